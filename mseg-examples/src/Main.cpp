@@ -56,7 +56,7 @@ void Pyramid_example()
 
   for(std::size_t i = 0; i <= nLevels; ++i)
     // Save level i-th to file
-    TePDIUtils::TeRaster2Geotiff(pyramid.getLevel(i), outputPath + "pyramid_level_" + Te2String(i) + ".tif", false);
+    TePDIUtils::TeRaster2Geotiff(pyramid.getLevel(i).createRaster(), outputPath + "pyramid_level_" + Te2String(i) + ".tif", false);
 }
 
 void PyramidStatistics_example()
@@ -77,17 +77,13 @@ void PyramidStatistics_example()
 
   for(std::size_t i = 0; i <= nLevels; ++i)
   {
-    // Build the statistics of the i-th level
-    TePDIStatistic* stats = pyramid.buildStats(i);
-    
+    // The statistics of the i-th level were computed while the pyramid was built
     std::cout << "* Statistics of Level " << i << std::endl;
     for(std::size_t b = 0; b < bands.size(); ++b)
     {
-      std::cout << "- Mean Band " << b << ": " << stats->getMean(b) << std::endl;
-      std::cout << "- Variance Band " << b << ": " << stats->getVariance(b) << std::endl << std::endl;
+      std::cout << "- Mean Band " << b << ": " << pyramid.getMean(i, b) << std::endl;
+      std::cout << "- Variance Band " << b << ": " << pyramid.getVariance(i, b) << std::endl << std::endl;
     }
-
-    delete stats;
   }
 }
 
@@ -997,7 +997,7 @@ namespace OpSupportFunctions
       const TeRasterParams& output_raster_params, 
       double node_weight,
       double geoWest, double geoNorth,
-      double geoEast, double geoSouth, const std::map<std::size_t, Region*>& regions )
+      double geoEast, double geoSouth, const RegionTable& regions )
   {
     TEAGN_TRUE_OR_RETURN( ( ! reg_desc_file_name.empty() ), 
       "Invalid parameter : reg_desc_file_name" )
@@ -1132,10 +1132,8 @@ namespace OpSupportFunctions
               "region" ), "Error inserting XML node" );
               
             // Find Region
-            std::map<std::size_t, Region*>::const_iterator it = regions.find(curr_class_data.class_value_);
-            TEAGN_TRUE_OR_RETURN(it != regions.end(), "Error inserting XML node - Region not found!" );
-
-            Region* region = it->second;
+            Region* region = regions.get(curr_class_data.class_value_);
+            TEAGN_TRUE_OR_RETURN(region != 0, "Error inserting XML node - Region not found!" );
 
             ++attr_index;  
             TEAGN_TRUE_OR_RETURN( 
@@ -1265,10 +1263,8 @@ namespace OpSupportFunctions
               "region" ), "Error inserting XML node" );
               
              // Find Region
-            std::map<std::size_t, Region*>::const_iterator it = regions.find(curr_class_data.class_value_);
-            TEAGN_TRUE_OR_RETURN(it != regions.end(), "Error inserting XML node - Region not found!" );
-
-            Region* region = it->second;
+            Region* region = regions.get(curr_class_data.class_value_);
+            TEAGN_TRUE_OR_RETURN(region != 0, "Error inserting XML node - Region not found!" );
 
             ++attr_index;  
             TEAGN_TRUE_OR_RETURN( 
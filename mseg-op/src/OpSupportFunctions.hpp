@@ -6,6 +6,7 @@
 
   // MultiSeg
   #include <mseg/Region.h>
+  #include <mseg/RegionTable.h>
  
   // TerraLib 
   #include <terralib/image_processing/TePDIHaralick.hpp>
@@ -243,7 +244,7 @@
       const TeRasterParams& output_raster_params, 
       double node_weight, 
       double geoWest, double geoNorth,
-      double geoEast, double geoSouth, const std::map<std::size_t, Region*>& regions );
+      double geoEast, double geoSouth, const RegionTable& regions );
                   
     /**
      * @brief Resample the rasters to match dimentions (Bicubic).
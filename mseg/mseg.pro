@@ -4,6 +4,21 @@ TEMPLATE = lib
 
 DEFINES += MSEGDLL
 
+# OpenMP support (qmake CONFIG+=openmp): the image sweeps can use several threads. See MultiSeg::setNumberOfThreads()
+openmp {
+  win32-msvc* {
+    QMAKE_CXXFLAGS += /openmp
+  } else {
+    QMAKE_CXXFLAGS += -fopenmp
+    QMAKE_LFLAGS += -fopenmp
+  }
+}
+
+# Single precision storage (qmake CONFIG+=float32): the pyramid levels and the region statistics use 32 bits floats. See Config.h
+float32 {
+  DEFINES += MSEGFLOAT32
+}
+
 INCLUDEPATH = ../thirdparty/terralib/include \
               ../thirdparty/terralib/include/terralib \
               ../thirdparty/terralib/include/terralib/functions \
@@ -24,33 +39,55 @@ CONFIG(release, debug|release) {
 
 HEADERS += src/AbstractMerger.h \
            src/AbstractOutputter.h \
+           src/BoundaryTable.h \
            src/CompositeMerger.h \
            src/CVTable.h \
            src/Config.h \
+           src/CriticalValueTable.h \
            src/Enums.h \
            src/EuclideanMerger.h \
            src/FileOutputter.h \
+           src/LabelBuffer.h \
            src/MultiSeg.h \
+           src/Neighbourhood.h \
            src/OpticalCartoonMerger.h \
+           src/OpticalTextureMerger.h \
            src/ParallelMultiSegStrategy.h \
            src/ParallelMultiSegStrategyFactory.h \
+           src/PixelBuffer.h \
            src/Pyramid.h \
+           src/PyramidCache.h \
            src/RadarCartoonMerger.h \
+           src/RadarTextureMerger.h \
            src/Region.h \
+           src/RegionPool.h \
+           src/RegionTable.h \
+           src/TextureMerger.h \
            src/Utils.h
 
 SOURCES += src/AbstractMerger.cpp \
+           src/BoundaryTable.cpp \
            src/CompositeMerger.cpp \
+           src/CriticalValueTable.cpp \
            src/CVTable.cpp \
            src/EuclideanMerger.cpp \
            src/FileOutputter.cpp \
+           src/LabelBuffer.cpp \
            src/MultiSeg.cpp \
+           src/Neighbourhood.cpp \
            src/OpticalCartoonMerger.cpp \
+           src/OpticalTextureMerger.cpp \
            src/ParallelMultiSegStrategy.cpp \
            src/ParallelMultiSegStrategyFactory.cpp \
+           src/PixelBuffer.cpp \
            src/Pyramid.cpp \
+           src/PyramidCache.cpp \
            src/RadarCartoonMerger.cpp \
+           src/RadarTextureMerger.cpp \
            src/Region.cpp \
+           src/RegionPool.cpp \
+           src/RegionTable.cpp \
+           src/TextureMerger.cpp \
            src/Utils.cpp
 
 win32 {
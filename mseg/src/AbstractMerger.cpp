@@ -27,7 +27,23 @@
 #include "Region.h"
 
 // STL
+#include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+AbstractMerger::ParamBlock::ParamBlock()
+  : m_euclideanDistanceThreshold(0.0),
+    m_integerDistanceThreshold(0),
+    m_integerPixels(false),
+    m_cvThreshold(0.0),
+    m_vcriticFactor(0.0),
+    m_enl(0.0),
+    m_rootENL(0.0),
+    m_confidenceLevel(0.0)
+{
+}
 
 AbstractMerger::AbstractMerger()
   : m_strictMode(true)
@@ -41,11 +57,19 @@ AbstractMerger::~AbstractMerger()
 void AbstractMerger::setParam(const std::string& name, const double& value)
 {
   m_params[name] = value;
+
+  updateParamBlock(name, value);
 }
 
 void AbstractMerger::setParams(const std::map<std::string, double>& params)
 {
   m_params = params;
+
+  m_paramBlock = ParamBlock();
+
+  std::map<std::string, double>::const_iterator it;
+  for(it = m_params.begin(); it != m_params.end(); ++it)
+    updateParamBlock(it->first, it->second);
 }
 
 double AbstractMerger::getParam(const std::string& name) const
@@ -62,6 +86,21 @@ const std::map<std::string, double>& AbstractMerger::getParams() const
   return m_params;
 }
 
+bool AbstractMerger::isStrictMode() const
+{
+  return m_strictMode;
+}
+
+bool AbstractMerger::usesHigherMoments() const
+{
+  return false;
+}
+
+bool AbstractMerger::usesCooccurrences() const
+{
+  return false;
+}
+
 bool AbstractMerger::predicate(Region* r1, Region* r2) const
 {
   assert(r1);
@@ -130,12 +169,41 @@ bool AbstractMerger::isHomogenous(Region* r) const
   return false;
 }
 
+std::size_t AbstractMerger::predicates(Region* region, const std::vector<Region*>& regions,
+                                       std::vector<unsigned char>& passes, std::vector<double>& distances) const
+{
+  assert(region);
+
+  passes.resize(regions.size());
+  distances.resize(regions.size());
+
+  std::size_t nPasses = 0;
+
+  for(std::size_t i = 0; i < regions.size(); ++i)
+  {
+    if(predicate(region, regions[i]))
+    {
+      passes[i] = 1;
+      distances[i] = getSquaredEuclideanDistance(region, regions[i]);
+      ++nPasses;
+    }
+    else
+    {
+      passes[i] = 0;
+      distances[i] = (std::numeric_limits<double>::max)();
+    }
+  }
+
+  return nPasses;
+}
+
 double AbstractMerger::getSquaredEuclideanDistance(Region* r1, Region* r2) const
 {
   assert(r1);
   assert(r2);
+  assert(r1->getNBands() ==  r2->getNBands());
 
-  return getSquaredEuclideanDistance(r1->getMean(), r2->getMean());
+  return getSquaredEuclideanDistance(r1->getMean(), r2->getMean(), r1->getNBands());
 }
 
 double AbstractMerger::getSquaredEuclideanDistance(const std::vector<double>& p1,
@@ -146,14 +214,127 @@ double AbstractMerger::getSquaredEuclideanDistance(const std::vector<double>& p1
   double distance = 0.0;
 
   for(std::size_t i = 0; i < p1.size(); ++i)
-    distance += abs(p1[i] - p2[i]);
+    distance += std::fabs(p1[i] - p2[i]);
+
+  return distance;
+}
+
+double AbstractMerger::getSquaredEuclideanDistance(const Region::Statistic* p1, const Region::Statistic* p2, const std::size_t& nBands) const
+{
+  double distance = 0.0;
+
+  for(std::size_t i = 0; i < nBands; ++i)
+    distance += std::fabs(static_cast<double>(p1[i]) - p2[i]);
 
   return distance;
 }
 
+void AbstractMerger::getSquaredEuclideanDistances(Region* region, const std::vector<Region*>& regions,
+                                                  std::vector<double>& distances) const
+{
+  assert(region);
+
+  const std::size_t nBands = region->getNBands();
+  const Region::Statistic* mean = region->getMean();
+
+  distances.resize(regions.size());
+
+  std::size_t i = 0;
+
+  // Blocks of four regions
+  for(; i + 4 <= regions.size(); i += 4)
+  {
+    assert(regions[i]->getNBands() == nBands && regions[i + 1]->getNBands() == nBands &&
+           regions[i + 2]->getNBands() == nBands && regions[i + 3]->getNBands() == nBands);
+
+    const Region::Statistic* m0 = regions[i]->getMean();
+    const Region::Statistic* m1 = regions[i + 1]->getMean();
+    const Region::Statistic* m2 = regions[i + 2]->getMean();
+    const Region::Statistic* m3 = regions[i + 3]->getMean();
+
+    double d0 = 0.0;
+    double d1 = 0.0;
+    double d2 = 0.0;
+    double d3 = 0.0;
+
+    for(std::size_t b = 0; b < nBands; ++b)
+    {
+      const double v = mean[b];
+
+      d0 += std::fabs(v - m0[b]);
+      d1 += std::fabs(v - m1[b]);
+      d2 += std::fabs(v - m2[b]);
+      d3 += std::fabs(v - m3[b]);
+    }
+
+    distances[i] = d0;
+    distances[i + 1] = d1;
+    distances[i + 2] = d2;
+    distances[i + 3] = d3;
+  }
+
+  // Remaining regions
+  for(; i < regions.size(); ++i)
+  {
+    assert(regions[i]->getNBands() == nBands);
+    distances[i] = getSquaredEuclideanDistance(mean, regions[i]->getMean(), nBands);
+  }
+}
+
+void AbstractMerger::updateParamBlock(const std::string& name, const double& value)
+{
+  static const std::string imageVariancePrefix = "image_variance_";
+
+  if(name == "euclidean_distance_threshold")
+  {
+    m_paramBlock.m_euclideanDistanceThreshold = value;
+
+    // The differences of 8 or 16 bits values are integers in [0, 65535]
+    if(value < 0.0)
+      m_paramBlock.m_integerDistanceThreshold = -1;
+    else
+      m_paramBlock.m_integerDistanceThreshold = static_cast<int>(floor((std::min)(value, 65536.0)));
+  }
+  else if(name == "integer_pixels")
+  {
+    m_paramBlock.m_integerPixels = (value != 0.0);
+  }
+  else if(name == "cv_threshold")
+  {
+    m_paramBlock.m_cvThreshold = value;
+  }
+  else if(name == "vcritic_factor")
+  {
+    m_paramBlock.m_vcriticFactor = value;
+  }
+  else if(name == "ENL")
+  {
+    m_paramBlock.m_enl = value;
+    m_paramBlock.m_rootENL = sqrt(value);
+  }
+  else if(name == "confidence_level")
+  {
+    m_paramBlock.m_confidenceLevel = value;
+    m_paramBlock.m_criticalValues.reset(value);
+  }
+  else if(name.compare(0, imageVariancePrefix.size(), imageVariancePrefix) == 0)
+  {
+    std::size_t band = static_cast<std::size_t>(std::atoi(name.c_str() + imageVariancePrefix.size()));
+
+    if(band >= m_paramBlock.m_imageVariances.size())
+    {
+      m_paramBlock.m_imageVariances.resize(band + 1, 0.0);
+      m_paramBlock.m_imageStdDevs.resize(band + 1, 0.0);
+    }
+
+    m_paramBlock.m_imageVariances[band] = value;
+    m_paramBlock.m_imageStdDevs[band] = sqrt(value);
+  }
+}
+
 double AbstractMerger::getEuclideanDistance(Region* r1, Region* r2) const
 {
-  double distance = getSquaredEuclideanDistance(r1->getMean(), r2->getMean());
+  double distance = getSquaredEuclideanDistance(r1, r2);
 
   return sqrt(distance);
 }
@@ -27,15 +27,16 @@
 
 // MultiSeg
 #include "Config.h"
+#include "CriticalValueTable.h"
+#include "Region.h"
 
 // STL
+#include <cassert>
+#include <limits>
 #include <map>
 #include <string>
 #include <vector>
 
-// Forward declaration
-class Region;
-
 /*!
   \class AbstractMerger
 
@@ -58,6 +59,8 @@ class MSEGEXPORT AbstractMerger
 
       \param name The parameter name.
       \param value The parameter value.
+
+      \note The known parameters are also compiled into the typed parameter block read by the metrics.
     */
     virtual void setParam(const std::string& name, const double& value);
 
@@ -84,6 +87,13 @@ class MSEGEXPORT AbstractMerger
     */
     virtual const std::map<std::string, double>& getParams() const;
 
+    /*!
+      \brief This method indicates if this merger is on strict mode. i.e. if all bands must be homogeneous.
+
+      \return It returns true if this merger is on strict mode and false otherwise.
+    */
+    bool isStrictMode() const;
+
     /** @name Public abstract virtual methods
       * Methods related with the merger metrics. */
     //@{
@@ -117,6 +127,21 @@ class MSEGEXPORT AbstractMerger
     */
     virtual bool isHomogenous(Region* r) const;
 
+    /*!
+      \brief This method evaluates the predicate of homogeneity between a region and each one of the given regions,
+             and computes the squared euclidean distance to the homogeneous ones, in one call.
+
+      \param region    The region.
+      \param regions   The regions that will be evaluated. e.g. the neighbours of the given region.
+      \param passes    The predicate results, one for each given region, in the same order. 1 means homogeneous.
+      \param distances The squared euclidean distances, one for each given region, in the same order.
+                       It is the greatest double value for the regions that are not homogeneous.
+
+      \return The number of homogeneous regions.
+    */
+    virtual std::size_t predicates(Region* region, const std::vector<Region*>& regions,
+                                   std::vector<unsigned char>& passes, std::vector<double>& distances) const;
+
     /*!
       \brief This method performs the merging between two homogeneous regions.
 
@@ -127,6 +152,26 @@ class MSEGEXPORT AbstractMerger
 
     //@}
 
+    /** @name Statistics requirements
+      * Methods that indicate the optional region statistics that this merger reads. */
+    //@{
+
+    /*!
+      \brief This method indicates if this merger reads the third and fourth central moments of the regions.
+
+      \return It returns true if the regions must track their higher order moments. The default is false.
+    */
+    virtual bool usesHigherMoments() const;
+
+    /*!
+      \brief This method indicates if this merger reads the contrast of the regions.
+
+      \return It returns true if the regions must track their pixel pairs. The default is false.
+    */
+    virtual bool usesCooccurrences() const;
+
+    //@}
+
   protected:
 
     /** @name Protected abstract virtual methods
@@ -194,6 +239,33 @@ class MSEGEXPORT AbstractMerger
     double getSquaredEuclideanDistance(const std::vector<double>& p1,
                                        const std::vector<double>& p2) const;
 
+    /*!
+      \brief This method computes the squared euclidean distance between two region means.
+
+      \param p1     The first region mean.
+      \param p2     The second region mean.
+      \param nBands The number of bands of the regions.
+
+      \retrun The squared euclidean distance between two region means.
+
+      \note The distance is accumulated in double precision, whatever the storage type of the statistics.
+    */
+    double getSquaredEuclideanDistance(const Region::Statistic* p1, const Region::Statistic* p2, const std::size_t& nBands) const;
+
+    /*!
+      \brief This method computes the squared euclidean distance between a region and each one of the given regions.
+
+      \param region    The region.
+      \param regions   The regions that will be compared with the given region. e.g. its neighbours.
+      \param distances The computed distances, one for each given region, in the same order.
+
+      \note The regions are processed in blocks, so the band loop is shared and the region means,
+            that are contiguous on the region pool, are streamed with vectorizable loads. Each distance
+            is accumulated in the band order, so the values are identical to the one-by-one computation.
+    */
+    void getSquaredEuclideanDistances(Region* region, const std::vector<Region*>& regions,
+                                      std::vector<double>& distances) const;
+
     /*!
       \brief This method computes the euclidean distance between two regions.
 
@@ -217,12 +289,220 @@ class MSEGEXPORT AbstractMerger
 
     //@}
 
+    /** @name Band loops
+      * Loops over the bands instantiated with a concrete merger type. e.g. by the per pair methods of each merger,
+      * and by the segmentation passes of MultiSeg. The band methods are called through the concrete type, i.e.
+      * without virtual dispatch, so they can be inlined. The strict mode is a template parameter. The overloads
+      * without it dispatch the strict mode of the merger on each evaluation. */
+    //@{
+
+    template<class Merger> static bool evaluatePredicate(const Merger* merger, Region* r1, Region* r2);
+
+    template<class Merger, bool strict> static bool evaluatePredicate(const Merger* merger, Region* r1, Region* r2);
+
+    template<class Merger> static std::size_t evaluatePredicates(const Merger* merger, Region* region, const std::vector<Region*>& regions,
+                                                                 std::vector<unsigned char>& passes, std::vector<double>& distances);
+
+    template<class Merger, bool strict> static std::size_t evaluatePredicates(const Merger* merger, Region* region, const std::vector<Region*>& regions,
+                                                                              std::vector<unsigned char>& passes, std::vector<double>& distances);
+
+    template<bool strict> static bool evaluatePixelPredicate(const Region::Statistic* p1, const Region::Statistic* p2, const std::size_t& nBands,
+                                                             const int& threshold, double& distance);
+
+    template<class Merger> static double evaluateDissimilarity(const Merger* merger, const std::vector<double>& p, Region* r);
+
+    template<class Merger> static bool evaluateHomogeneity(const Merger* merger, Region* r);
+
+    template<class Merger, bool strict> static bool evaluateHomogeneity(const Merger* merger, Region* r);
+
+    //@}
+
+  private:
+
+    /*! \brief This method updates the typed parameter block with the given parameter. Unknown names are ignored. */
+    void updateParamBlock(const std::string& name, const double& value);
+
   protected:
 
+    /*!
+      \struct ParamBlock
+
+      \brief The typed values of the merger parameters, with some precomputed values.
+
+      It is updated by setParam() and setParams(), e.g. once per level, so the metrics read the values
+      directly instead of searching them by name on each evaluation. A parameter that was not set is 0.0.
+
+      \note If "integer_pixels" is set, two pixels are compared through integer differences. All mergers
+            compare two pixels through the euclidean predicate, so it does not change the results.
+    */
+    struct ParamBlock
+    {
+      double m_euclideanDistanceThreshold;   //!< The "euclidean_distance_threshold" parameter.
+      int m_integerDistanceThreshold;        //!< The "euclidean_distance_threshold" parameter to integer differences. -1 means none.
+      bool m_integerPixels;                  //!< The "integer_pixels" parameter. i.e. if the pixels are 8 or 16 bits integers.
+      double m_cvThreshold;                  //!< The "cv_threshold" parameter.
+      double m_vcriticFactor;                //!< The "vcritic_factor" parameter.
+      double m_enl;                          //!< The "ENL" parameter.
+      double m_rootENL;                      //!< The square root of the "ENL" parameter.
+      double m_confidenceLevel;              //!< The "confidence_level" parameter.
+      std::vector<double> m_imageVariances;  //!< The "image_variance_<band>" parameters, indexed by band.
+      std::vector<double> m_imageStdDevs;    //!< The square root of the "image_variance_<band>" parameters, indexed by band.
+      CriticalValueTable m_criticalValues;   //!< The critical values of the statistical tests at the "confidence_level" parameter.
+
+      ParamBlock();
+    };
+
     std::map<std::string, double> m_params; //!< The specific parameter list of this merger.
+    ParamBlock m_paramBlock;                //!< The typed values of the parameter list.
     bool m_strictMode;                      //!< A flag that indicates if this merger is on strict mode.
 
   friend class CompositeMerger;
 };
 
+template<class Merger> inline bool AbstractMerger::evaluatePredicate(const Merger* merger, Region* r1, Region* r2)
+{
+  assert(merger);
+
+  return merger->m_strictMode ? evaluatePredicate<Merger, true>(merger, r1, r2) :
+                                evaluatePredicate<Merger, false>(merger, r1, r2);
+}
+
+template<class Merger, bool strict> inline bool AbstractMerger::evaluatePredicate(const Merger* merger, Region* r1, Region* r2)
+{
+  assert(r1);
+  assert(r2);
+  assert(r1->getNBands() ==  r2->getNBands());
+
+  const std::size_t nBands = r1->getNBands();
+
+  for(std::size_t i = 0; i < nBands; ++i)
+  {
+    bool isValid = merger->Merger::predicate(r1, r2, i);
+
+    // Strict: all bands must be valid. Otherwise, one valid band is enough
+    if(isValid != strict)
+      return isValid;
+  }
+
+  return strict && nBands > 0;
+}
+
+template<class Merger> inline std::size_t AbstractMerger::evaluatePredicates(const Merger* merger, Region* region, const std::vector<Region*>& regions,
+                                                                            std::vector<unsigned char>& passes, std::vector<double>& distances)
+{
+  assert(merger);
+
+  return merger->m_strictMode ? evaluatePredicates<Merger, true>(merger, region, regions, passes, distances) :
+                                evaluatePredicates<Merger, false>(merger, region, regions, passes, distances);
+}
+
+template<class Merger, bool strict> inline std::size_t AbstractMerger::evaluatePredicates(const Merger* merger, Region* region, const std::vector<Region*>& regions,
+                                                                                         std::vector<unsigned char>& passes, std::vector<double>& distances)
+{
+  assert(region);
+
+  const std::size_t nBands = region->getNBands();
+  const Region::Statistic* mean = region->getMean();
+
+  passes.resize(regions.size());
+  distances.resize(regions.size());
+
+  std::size_t nPasses = 0;
+
+  // Pixel vs. pixels of 8 or 16 bits images: integer differences
+  const bool integerPixels = merger->m_paramBlock.m_integerPixels && region->getSize() == 1;
+  const int integerThreshold = merger->m_paramBlock.m_integerDistanceThreshold;
+
+  for(std::size_t i = 0; i < regions.size(); ++i)
+  {
+    if(integerPixels && regions[i]->getSize() == 1)
+    {
+      if(evaluatePixelPredicate<strict>(mean, regions[i]->getMean(), nBands, integerThreshold, distances[i]))
+      {
+        passes[i] = 1;
+        ++nPasses;
+      }
+      else
+      {
+        passes[i] = 0;
+        distances[i] = (std::numeric_limits<double>::max)();
+      }
+    }
+    else if(evaluatePredicate<Merger, strict>(merger, region, regions[i]))
+    {
+      passes[i] = 1;
+      distances[i] = merger->getSquaredEuclideanDistance(mean, regions[i]->getMean(), nBands);
+      ++nPasses;
+    }
+    else
+    {
+      passes[i] = 0;
+      distances[i] = (std::numeric_limits<double>::max)();
+    }
+  }
+
+  return nPasses;
+}
+
+template<bool strict> inline bool AbstractMerger::evaluatePixelPredicate(const Region::Statistic* p1, const Region::Statistic* p2, const std::size_t& nBands,
+                                                                         const int& threshold, double& distance)
+{
+  int sum = 0;
+  std::size_t valids = 0;
+
+  // No branches: the loop can be vectorized to integer absolute differences and compares
+  for(std::size_t i = 0; i < nBands; ++i)
+  {
+    int difference = static_cast<int>(p1[i]) - static_cast<int>(p2[i]);
+    difference = difference < 0 ? -difference : difference;
+
+    sum += difference;
+    valids += (difference <= threshold);
+  }
+
+  // The sum of the absolute differences is exact, so it is equal to getSquaredEuclideanDistance()
+  distance = static_cast<double>(sum);
+
+  // Strict: all bands must be valid. Otherwise, one valid band is enough
+  return strict ? (nBands > 0 && valids == nBands) : valids > 0;
+}
+
+template<class Merger> inline double AbstractMerger::evaluateDissimilarity(const Merger* merger, const std::vector<double>& p, Region* r)
+{
+  assert(merger);
+
+  double value = 0.0;
+
+  for(std::size_t i = 0; i < p.size(); ++i)
+    value += merger->Merger::getDissimilarity(p, r, i);
+
+  return value;
+}
+
+template<class Merger> inline bool AbstractMerger::evaluateHomogeneity(const Merger* merger, Region* r)
+{
+  assert(merger);
+
+  return merger->m_strictMode ? evaluateHomogeneity<Merger, true>(merger, r) :
+                                evaluateHomogeneity<Merger, false>(merger, r);
+}
+
+template<class Merger, bool strict> inline bool AbstractMerger::evaluateHomogeneity(const Merger* merger, Region* r)
+{
+  assert(r);
+
+  const std::size_t nBands = r->getNBands();
+
+  for(std::size_t i = 0; i < nBands; ++i)
+  {
+    bool isHomo = merger->Merger::isHomogenous(r, i);
+
+    // Strict: all bands must be homogeneous. Otherwise, one homogeneous band is enough
+    if(isHomo != strict)
+      return isHomo;
+  }
+
+  return strict && nBands > 0;
+}
+
 #endif // __MULTISEG_INTERNAL_ABSTRACTMERGER_H
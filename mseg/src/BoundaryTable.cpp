@@ -0,0 +1,216 @@
+/*  Copyright (C) 2014 National Institute For Space Research (INPE) - Brazil.
+
+    MultiSeg is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    MultiSeg is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with MultiSeg. See COPYING.
+ */
+
+
+/*!
+  \file BoundaryTable.cpp
+
+  \brief This class implements a table of the pixel pairs across the boundary of each pair of neighbour regions.
+
+  \author Douglas Uba <douglas@dpi.inpe.br>
+*/
+
+// MultiSeg
+#include "BoundaryTable.h"
+
+// STL
+#include <algorithm>
+#include <cassert>
+
+BoundaryTable::BoundaryTable()
+  : m_nBands(0)
+{
+}
+
+BoundaryTable::~BoundaryTable()
+{
+}
+
+void BoundaryTable::reset(const std::size_t& nBands)
+{
+  m_nBands = nBands;
+
+  m_slots.clear();
+  m_nPairs.clear();
+  m_squares.clear();
+  m_freeSlots.clear();
+  m_others.clear();
+}
+
+void BoundaryTable::clear()
+{
+  boost::unordered_map<Key, std::size_t>().swap(m_slots);
+  std::vector<std::size_t>().swap(m_nPairs);
+  std::vector<double>().swap(m_squares);
+  std::vector<std::size_t>().swap(m_freeSlots);
+  boost::unordered_map<std::size_t, std::vector<std::size_t> >().swap(m_others);
+}
+
+std::size_t BoundaryTable::getNBands() const
+{
+  return m_nBands;
+}
+
+std::size_t BoundaryTable::size() const
+{
+  return m_slots.size();
+}
+
+void BoundaryTable::add(const std::size_t& id1, const std::size_t& id2, const std::size_t& nPairs, const double* squares)
+{
+  assert(id1 != id2);
+
+  if(nPairs == 0)
+    return;
+
+  std::pair<boost::unordered_map<Key, std::size_t>::iterator, bool> result = m_slots.insert(std::make_pair(makeKey(id1, id2), m_nPairs.size()));
+
+  std::size_t& slot = result.first->second;
+
+  // A new boundary: reuses a slot or appends one
+  if(result.second)
+  {
+    if(!m_freeSlots.empty())
+    {
+      slot = m_freeSlots.back();
+      m_freeSlots.pop_back();
+    }
+    else
+    {
+      m_nPairs.push_back(0);
+      m_squares.resize(m_squares.size() + m_nBands, 0.0);
+    }
+
+    m_nPairs[slot] = 0;
+    std::fill(m_squares.begin() + slot * m_nBands, m_squares.begin() + (slot + 1) * m_nBands, 0.0);
+
+    m_others[id1].push_back(id2);
+    m_others[id2].push_back(id1);
+  }
+
+  double* values = &m_squares[slot * m_nBands];
+
+  for(std::size_t b = 0; b < m_nBands; ++b)
+    values[b] += squares[b];
+
+  m_nPairs[slot] += nPairs;
+}
+
+std::size_t BoundaryTable::merge(const std::size_t& from, const std::size_t& into, std::vector<double>& squares)
+{
+  assert(from != into);
+
+  squares.assign(m_nBands, 0.0);
+
+  boost::unordered_map<std::size_t, std::vector<std::size_t> >::iterator othersIt = m_others.find(from);
+  if(othersIt == m_others.end())
+    return 0;
+
+  // The boundaries of the merged region
+  std::vector<std::size_t> others;
+  others.swap(othersIt->second);
+  m_others.erase(othersIt);
+
+  std::size_t nPairs = 0;
+
+  // The pixel pairs of a boundary. Note: they are copied, since add() can reuse or grow the slots
+  std::vector<double> values(m_nBands, 0.0);
+
+  for(std::size_t i = 0; i < others.size(); ++i)
+  {
+    const std::size_t other = others[i];
+    const Key key = makeKey(from, other);
+
+    boost::unordered_map<Key, std::size_t>::iterator it = m_slots.find(key);
+    assert(it != m_slots.end());
+
+    const std::size_t slot = it->second;
+    const std::size_t count = m_nPairs[slot];
+
+    std::copy(m_squares.begin() + slot * m_nBands, m_squares.begin() + (slot + 1) * m_nBands, values.begin());
+
+    release(key, slot);
+    unlink(other, from);
+
+    // The boundary between both regions: its pixel pairs are inside the grown region
+    if(other == into)
+    {
+      nPairs = count;
+      squares = values;
+      continue;
+    }
+
+    // The boundary of into and other grows
+    add(into, other, count, &values[0]);
+  }
+
+  return nPairs;
+}
+
+void BoundaryTable::erase(const std::size_t& id)
+{
+  boost::unordered_map<std::size_t, std::vector<std::size_t> >::iterator othersIt = m_others.find(id);
+  if(othersIt == m_others.end())
+    return;
+
+  const std::vector<std::size_t>& others = othersIt->second;
+
+  for(std::size_t i = 0; i < others.size(); ++i)
+  {
+    const Key key = makeKey(id, others[i]);
+
+    boost::unordered_map<Key, std::size_t>::iterator it = m_slots.find(key);
+    assert(it != m_slots.end());
+
+    release(key, it->second);
+    unlink(others[i], id);
+  }
+
+  m_others.erase(othersIt);
+}
+
+void BoundaryTable::addTo(BoundaryTable& table) const
+{
+  assert(table.getNBands() == m_nBands);
+
+  boost::unordered_map<Key, std::size_t>::const_iterator it;
+  for(it = m_slots.begin(); it != m_slots.end(); ++it)
+    table.add(it->first.first, it->first.second, m_nPairs[it->second], &m_squares[0] + it->second * m_nBands);
+}
+
+void BoundaryTable::release(const Key& key, const std::size_t& slot)
+{
+  m_slots.erase(key);
+  m_freeSlots.push_back(slot);
+}
+
+void BoundaryTable::unlink(const std::size_t& id, const std::size_t& other)
+{
+  boost::unordered_map<std::size_t, std::vector<std::size_t> >::iterator othersIt = m_others.find(id);
+  assert(othersIt != m_others.end());
+
+  std::vector<std::size_t>& others = othersIt->second;
+
+  std::vector<std::size_t>::iterator it = std::find(others.begin(), others.end(), other);
+  assert(it != others.end());
+
+  // The order of the boundaries does not matter
+  *it = others.back();
+  others.pop_back();
+
+  if(others.empty())
+    m_others.erase(othersIt);
+}
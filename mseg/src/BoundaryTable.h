@@ -0,0 +1,154 @@
+/*  Copyright (C) 2014 National Institute For Space Research (INPE) - Brazil.
+
+    MultiSeg is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    MultiSeg is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with MultiSeg. See COPYING.
+ */
+
+
+/*!
+  \file BoundaryTable.h
+
+  \brief This class implements a table of the pixel pairs across the boundary of each pair of neighbour regions.
+
+  \author Douglas Uba <douglas@dpi.inpe.br>
+*/
+
+#ifndef __MULTISEG_INTERNAL_BOUNDARYTABLE_H
+#define __MULTISEG_INTERNAL_BOUNDARYTABLE_H
+
+// MultiSeg
+#include "Config.h"
+
+// Boost
+#include <boost/unordered_map.hpp>
+
+// STL
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+/*!
+  \class BoundaryTable
+
+  \brief This class implements a table of the pixel pairs across the boundary of each pair of neighbour regions.
+
+  A pixel pair is two horizontal or vertical neighbour pixels. For each pair of regions, the table keeps the number
+  of pixel pairs with a pixel on each region and the sums of their squared differences, for each band. When two
+  regions are merged, their boundary pairs become pairs of the new region (see Region::addPixelPairs()), and the
+  boundaries of the merged region become boundaries of the grown one. So, the contrast of the regions is kept exact
+  through the merges, in O(bands) for each neighbour of the merged region.
+
+  \note The pairs of regions are unordered. i.e. (a, b) and (b, a) are the same boundary.
+*/
+class MSEGEXPORT BoundaryTable
+{
+  public:
+
+    /*! \brief Default constructor. It creates an empty table without bands. */
+    BoundaryTable();
+
+    /*! \brief Destructor. */
+    ~BoundaryTable();
+
+    /*!
+      \brief This method removes all boundaries and sets the number of bands.
+
+      \param nBands The number of bands.
+    */
+    void reset(const std::size_t& nBands);
+
+    /*! \brief This method removes all boundaries and releases the memory. */
+    void clear();
+
+    /*!
+      \brief This method returns the number of bands.
+
+      \return The number of bands.
+    */
+    std::size_t getNBands() const;
+
+    /*!
+      \brief This method returns the number of boundaries.
+
+      \return The number of boundaries.
+    */
+    std::size_t size() const;
+
+    /*!
+      \brief This method adds pixel pairs to the boundary of two regions.
+
+      \param id1     The identifier of the first region.
+      \param id2     The identifier of the second region.
+      \param nPairs  The number of pixel pairs.
+      \param squares The sum of the squared differences of the pixel pairs. i.e. getNBands() values.
+    */
+    void add(const std::size_t& id1, const std::size_t& id2, const std::size_t& nPairs, const double* squares);
+
+    /*!
+      \brief This method merges the boundaries of a region into the ones of another region.
+
+      The boundary between both regions is removed and its pixel pairs are returned. i.e. they are now inside
+      the region into. The other boundaries of the region from become boundaries of the region into.
+
+      \param from    The identifier of the merged region.
+      \param into    The identifier of the region that absorbed the merged region.
+      \param squares It receives the sum of the squared differences of the pixel pairs between both regions. i.e. getNBands() values.
+
+      \return The number of pixel pairs between both regions. 0 if they have no boundary.
+    */
+    std::size_t merge(const std::size_t& from, const std::size_t& into, std::vector<double>& squares);
+
+    /*!
+      \brief This method removes all boundaries of a region.
+
+      \param id The identifier of the region.
+    */
+    void erase(const std::size_t& id);
+
+    /*!
+      \brief This method adds all boundaries of this table to the given table.
+
+      \param table The table that receives the boundaries. It must have the same number of bands.
+    */
+    void addTo(BoundaryTable& table) const;
+
+  private:
+
+    /*! \brief The key of a boundary: the ordered pair of region identifiers. */
+    typedef std::pair<std::size_t, std::size_t> Key;
+
+    /*! \brief It returns the key of the boundary of the given regions. */
+    static Key makeKey(const std::size_t& id1, const std::size_t& id2);
+
+    /*! \brief It removes the given slot from the slots. Its values are kept until the slot is reused. */
+    void release(const Key& key, const std::size_t& slot);
+
+    /*! \brief It removes the region other from the list of the regions that have a boundary with the region id. */
+    void unlink(const std::size_t& id, const std::size_t& other);
+
+  private:
+
+    std::size_t m_nBands;                            //!< The number of bands.
+    boost::unordered_map<Key, std::size_t> m_slots;  //!< The slot of each boundary.
+    std::vector<std::size_t> m_nPairs;               //!< The number of pixel pairs of each slot.
+    std::vector<double> m_squares;                   //!< The sums of the squared differences of each slot. m_nBands values for each slot.
+    std::vector<std::size_t> m_freeSlots;            //!< The slots of the removed boundaries.
+    boost::unordered_map<std::size_t, std::vector<std::size_t> > m_others; //!< The regions that have a boundary with each region.
+};
+
+inline BoundaryTable::Key BoundaryTable::makeKey(const std::size_t& id1, const std::size_t& id2)
+{
+  return id1 < id2 ? Key(id1, id2) : Key(id2, id1);
+}
+
+#endif // __MULTISEG_INTERNAL_BOUNDARYTABLE_H
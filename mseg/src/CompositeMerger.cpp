@@ -66,6 +66,24 @@ void CompositeMerger::merge(Region* r1, Region* r2) const
       m_mergers[i]->merge(r1, r2);
 }
 
+bool CompositeMerger::usesHigherMoments() const
+{
+  for(std::size_t i = 0; i < m_mergers.size(); ++i)
+    if(m_mergers[i]->usesHigherMoments())
+      return true;
+
+  return false;
+}
+
+bool CompositeMerger::usesCooccurrences() const
+{
+  for(std::size_t i = 0; i < m_mergers.size(); ++i)
+    if(m_mergers[i]->usesCooccurrences())
+      return true;
+
+  return false;
+}
+
 bool CompositeMerger::predicate(Region* r1, Region* r2, const std::size_t& band) const
 {
   return getMerger(band)->predicate(r1, r2, band);
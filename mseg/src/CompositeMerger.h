@@ -61,6 +61,10 @@ class MSEGEXPORT CompositeMerger : public AbstractMerger
 
     void merge(Region* r1, Region* r2) const;
 
+    bool usesHigherMoments() const;
+
+    bool usesCooccurrences() const;
+
   protected:
 
     bool predicate(Region* r1, Region* r2, const std::size_t& band) const;
@@ -60,4 +60,33 @@
 
 //@}
 
+/** @name Precision
+ *  Flags for the storage precision of the intermediate images and of the region statistics
+ */
+//@{
+
+/*!
+  \def MSEGFLOAT32
+
+  \brief Define it in order to store the pyramid levels, the intensity images and the region statistics
+         in single precision (32 bits), instead of double precision. It halves their memory footprint.
+
+  \note The sums and the metrics are still computed in double precision. Only the stored values are rounded.
+
+  \note It changes the layout of the Region class. So, the client code must be compiled with the same flag.
+*/
+
+/*!
+  \def MSEG_STORAGE_DATATYPE
+
+  \brief The TerraLib data type of the intermediate images. TeFLOAT if MSEGFLOAT32 is defined, TeDOUBLE otherwise.
+*/
+#ifdef MSEGFLOAT32
+  #define MSEG_STORAGE_DATATYPE TeFLOAT
+#else
+  #define MSEG_STORAGE_DATATYPE TeDOUBLE
+#endif
+
+//@}
+
 #endif  // __MULTISEG_INTERNAL_CONFIG_H
@@ -0,0 +1,107 @@
+/*  Copyright (C) 2014 National Institute For Space Research (INPE) - Brazil.
+
+    MultiSeg is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    MultiSeg is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with MultiSeg. See COPYING.
+ */
+
+/*!
+  \file CriticalValueTable.cpp
+
+  \brief This class represents a table of critical values of the t-Student and normal distributions.
+
+  \author Douglas Uba <douglas@dpi.inpe.br>
+*/
+
+// MultiSeg
+#include "CriticalValueTable.h"
+
+// Boost
+#include <boost/math/distributions/normal.hpp>
+#include <boost/math/distributions/students_t.hpp>
+
+// STL
+#include <cassert>
+#include <limits>
+
+CriticalValueTable::CriticalValueTable()
+{
+  reset(0.95);
+}
+
+CriticalValueTable::~CriticalValueTable()
+{
+}
+
+void CriticalValueTable::reset(const double& confidenceLevel)
+{
+  m_confidenceLevel = confidenceLevel;
+  m_t.clear();
+
+  // Degenerated levels: all tests pass or all tests fail
+  if(m_confidenceLevel >= 1.0)
+  {
+    m_z = (std::numeric_limits<double>::max)();
+    return;
+  }
+
+  if(m_confidenceLevel <= 0.0)
+  {
+    m_z = -(std::numeric_limits<double>::max)();
+    return;
+  }
+
+  boost::math::normal_distribution<double> normal;
+  m_z = boost::math::quantile(normal, m_confidenceLevel);
+}
+
+double CriticalValueTable::getT(const std::size_t& dof) const
+{
+  assert(dof > 0);
+
+  if(dof > sm_maxTableDOF)
+    return computeT(dof);
+
+  // Fills the table up to the requested degrees of freedom
+  while(m_t.size() <= dof)
+    m_t.push_back(m_t.empty() ? 0.0 : computeT(m_t.size()));
+
+  return m_t[dof];
+}
+
+double CriticalValueTable::getZ() const
+{
+  return m_z;
+}
+
+double CriticalValueTable::computeT(const std::size_t& dof) const
+{
+  if(m_confidenceLevel >= 1.0 || m_confidenceLevel <= 0.0)
+    return m_z;
+
+  if(dof <= sm_maxTableDOF)
+  {
+    boost::math::students_t_distribution<double> tStudent(static_cast<double>(dof));
+    return boost::math::quantile(tStudent, m_confidenceLevel);
+  }
+
+  // Cornish-Fisher expansion of the t-Student quantile from the normal quantile
+  const double z = m_z;
+  const double z2 = z * z;
+  const double v = static_cast<double>(dof);
+
+  double g1 = (z2 + 1.0) * z / 4.0;
+  double g2 = ((5.0 * z2 + 16.0) * z2 + 3.0) * z / 96.0;
+  double g3 = (((3.0 * z2 + 19.0) * z2 + 17.0) * z2 - 15.0) * z / 384.0;
+
+  return z + g1 / v + g2 / (v * v) + g3 / (v * v * v);
+}
@@ -0,0 +1,95 @@
+/*  Copyright (C) 2014 National Institute For Space Research (INPE) - Brazil.
+
+    MultiSeg is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    MultiSeg is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with MultiSeg. See COPYING.
+ */
+
+/*!
+  \file CriticalValueTable.h
+
+  \brief This class represents a table of critical values of the t-Student and normal distributions.
+
+  \author Douglas Uba <douglas@dpi.inpe.br>
+*/
+
+#ifndef __MULTISEG_INTERNAL_CRITICALVALUETABLE_H
+#define __MULTISEG_INTERNAL_CRITICALVALUETABLE_H
+
+// MultiSeg
+#include "Config.h"
+
+// STL
+#include <cstddef>
+#include <vector>
+
+/*!
+  \class CriticalValueTable
+
+  \brief This class represents a table of critical values of the t-Student and normal distributions.
+
+  A one-tailed test "p = 1 - cdf(x) >= 1 - confidence level" is equivalent to "x <= quantile(confidence level)".
+  So, the mergers compare the test statistic with a critical value instead of evaluating the distribution
+  function for each pair of regions.
+
+  The t-Student critical values are computed on demand and cached for each degree of freedom. Beyond
+  sm_maxTableDOF degrees of freedom, an asymptotic (Cornish-Fisher) expansion from the normal critical value
+  is used.
+*/
+class MSEGEXPORT CriticalValueTable
+{
+  public:
+
+    /*! \brief Default constructor. It creates a table for the confidence level 0.95. */
+    CriticalValueTable();
+
+    /*! \brief Destructor. */
+    ~CriticalValueTable();
+
+    /*!
+      \brief This method discards the cached values and sets the confidence level of the table.
+
+      \param confidenceLevel The confidence level of the table.
+    */
+    void reset(const double& confidenceLevel);
+
+    /*!
+      \brief This method returns the critical value of the t-Student distribution.
+
+      \param dof The number of degrees of freedom. It must be greater than 0.
+
+      \return The critical value of the t-Student distribution for the given degrees of freedom.
+    */
+    double getT(const std::size_t& dof) const;
+
+    /*!
+      \brief This method returns the critical value of the standard normal distribution.
+
+      \return The critical value of the standard normal distribution.
+    */
+    double getZ() const;
+
+  private:
+
+    /*! \brief This method computes the critical value of the t-Student distribution through the given degrees of freedom. */
+    double computeT(const std::size_t& dof) const;
+
+  private:
+
+    static const std::size_t sm_maxTableDOF = 4096; //!< The greatest number of degrees of freedom whose critical value is cached.
+
+    double m_confidenceLevel;                       //!< The confidence level of the table.
+    double m_z;                                     //!< The critical value of the standard normal distribution.
+    mutable std::vector<double> m_t;                //!< The cached critical values of the t-Student distribution, indexed by degrees of freedom.
+};
+
+#endif // __MULTISEG_INTERNAL_CRITICALVALUETABLE_H
@@ -84,6 +84,16 @@
     Vector,        /*!< The vector that represents the region boundaries. */
   };
 
+  /*!
+    \enum RegionGrowingStrategy
+    \brief Defines how the candidate merges are searched during the region growing process.
+  */
+  enum RegionGrowingStrategy
+  {
+    Passes,       /*!< Repeated passes over all regions until a pass merges nothing.        */
+    PriorityQueue /*!< A global queue of candidate merges, ordered by the euclidean distance. */
+  };
+
 //@}
 
 #endif // __MULTISEG_INTERNAL_ENUMS_H
@@ -39,64 +39,70 @@ EuclideanMerger::~EuclideanMerger()
 {
 }
 
-void EuclideanMerger::merge(Region* r1, Region* r2) const
+bool EuclideanMerger::predicate(Region* r1, Region* r2) const
 {
-  assert(r1);
-  assert(r2);
-  assert(r1->getNBands() ==  r2->getNBands());
-
-  // Updating bounds
-  r1->updateBounds(r2);
-
-  // Updating Mean
-  std::vector<double>& mean1 = r1->getMean();
-  const std::vector<double>& mean2 = r2->getMean();
+  return evaluatePredicate(this, r1, r2);
+}
 
-  const std::size_t& size1 = r1->getSize();
-  const std::size_t& size2 = r2->getSize();
+double EuclideanMerger::getDissimilarity(const std::vector<double>& p, Region* r) const
+{
+  return evaluateDissimilarity(this, p, r);
+}
 
-  for(std::size_t i = 0; i < mean1.size(); ++i)
-    mean1[i] = ((mean1[i] * size1) + (mean2[i] * size2)) / ((double)(size1 + size2));
+std::size_t EuclideanMerger::predicates(Region* region, const std::vector<Region*>& regions,
+                                        std::vector<unsigned char>& passes, std::vector<double>& distances) const
+{
+  return evaluatePredicates(this, region, regions, passes, distances);
+}
 
-  // Updating size
-  r1->setSize(size1 + size2);
+bool EuclideanMerger::isHomogenous(Region* r) const
+{
+  return evaluateHomogeneity(this, r);
 }
 
-bool EuclideanMerger::predicate(Region* r1, Region* r2, const std::size_t& band) const
+void EuclideanMerger::merge(Region* r1, Region* r2) const
 {
   assert(r1);
   assert(r2);
   assert(r1->getNBands() ==  r2->getNBands());
 
-  const std::vector<double>& mean1 = r1->getMean();
-  const std::vector<double>& mean2 = r2->getMean();
+  // Updating bounds
+  r1->updateBounds(r2);
 
-  assert(band < mean1.size());
+  Region::Statistic* mean1 = r1->getMean();
+  const Region::Statistic* mean2 = r2->getMean();
 
-  double t = getParam("euclidean_distance_threshold");
+  Region::Statistic* variance1 = r1->getVariance();
+  const Region::Statistic* variance2 = r2->getVariance();
 
-  return abs(mean1[band] - mean2[band]) <= t;
-}
+  Region::Statistic* cv1 = r1->getCV();
 
-double EuclideanMerger::getDissimilarity(const std::vector<double>& p, Region* r, const std::size_t& band) const
-{
-  assert(r);
+  const std::size_t& size1 = r1->getSize();
+  const std::size_t& size2 = r2->getSize();
 
-  const std::vector<double>& mean = r->getMean();
+  const double n1 = static_cast<double>(size1);
+  const double n2 = static_cast<double>(size2);
+  const double n = static_cast<double>(size1 + size2);
 
-  assert(p.size() == mean.size());
-  assert(band < p.size());
+  for(std::size_t i = 0; i < r1->getNBands(); ++i)
+  {
+    // Updating Variance: combines the sums of squared deviations (n * variance) of both regions (Chan et al.)
+    double delta = static_cast<double>(mean2[i]) - mean1[i];
+    double variance = ((variance1[i] * n1) + (variance2[i] * n2) + (delta * delta * n1 * n2 / n)) / n;
 
-  return abs(p[band] - mean[band]);
-}
+    // Updating Mean
+    double mean = ((mean1[i] * n1) + (mean2[i] * n2)) / n;
 
-bool EuclideanMerger::isHomogenous(Region* r, const std::size_t& band) const
-{
-  const std::vector<double>& cv = r->getCV();
+    mean1[i] = static_cast<Region::Statistic>(mean);
+    variance1[i] = static_cast<Region::Statistic>(variance);
 
-  assert(band < cv.size());
+    // Updating Coefficient of Variation
+    if(mean != 0.0)
+      cv1[i] = static_cast<Region::Statistic>(sqrt(variance) / mean);
+    else
+      cv1[i] = 0.0;
+  }
 
-  double t = getParam("cv_threshold");
-
-  return cv[band] <= t;
+  // Updating size
+  r1->setSize(size1 + size2);
 }
@@ -29,6 +29,10 @@
 #include "AbstractMerger.h"
 #include "Config.h"
 
+// STL
+#include <cassert>
+#include <cmath>
+
 /*!
   \class EuclideanMerger
 
@@ -46,6 +50,23 @@ class MSEGEXPORT EuclideanMerger : public AbstractMerger
     /*! \brief Virtual destructor. */
     virtual ~EuclideanMerger();
 
+    bool predicate(Region* r1, Region* r2) const;
+
+    double getDissimilarity(const std::vector<double>& p, Region* r) const;
+
+    bool isHomogenous(Region* r) const;
+
+    std::size_t predicates(Region* region, const std::vector<Region*>& regions,
+                           std::vector<unsigned char>& passes, std::vector<double>& distances) const;
+
+    /*!
+      \brief This method merges the region r2 into the region r1.
+
+      \param r1 The region that will grow.
+      \param r2 The region that will be merged.
+
+      \note The size, mean, variance and coefficient of variation of r1 are updated from the statistics of both regions.
+    */
     void merge(Region* r1, Region* r2) const;
 
   protected:
@@ -55,6 +76,43 @@ class MSEGEXPORT EuclideanMerger : public AbstractMerger
     virtual double getDissimilarity(const std::vector<double>& p, Region* r, const std::size_t& band) const;
 
     bool isHomogenous(Region* r, const std::size_t& band) const;
+
+  friend class AbstractMerger;
 };
 
+inline bool EuclideanMerger::predicate(Region* r1, Region* r2, const std::size_t& band) const
+{
+  assert(r1);
+  assert(r2);
+  assert(r1->getNBands() ==  r2->getNBands());
+
+  const Region::Statistic* mean1 = r1->getMean();
+  const Region::Statistic* mean2 = r2->getMean();
+
+  assert(band < r1->getNBands());
+
+  return std::abs(mean1[band] - mean2[band]) <= m_paramBlock.m_euclideanDistanceThreshold;
+}
+
+inline double EuclideanMerger::getDissimilarity(const std::vector<double>& p, Region* r, const std::size_t& band) const
+{
+  assert(r);
+
+  const Region::Statistic* mean = r->getMean();
+
+  assert(p.size() == r->getNBands());
+  assert(band < p.size());
+
+  return std::abs(p[band] - mean[band]);
+}
+
+inline bool EuclideanMerger::isHomogenous(Region* r, const std::size_t& band) const
+{
+  const Region::Statistic* cv = r->getCV();
+
+  assert(band < r->getNBands());
+
+  return cv[band] <= m_paramBlock.m_cvThreshold;
+}
+
 #endif // __MULTISEG_INTERNAL_EUCLIDEANMERGER_H
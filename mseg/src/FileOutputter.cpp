@@ -46,7 +46,7 @@ FileOutputter::~FileOutputter()
 void FileOutputter::outputPyramid(const Pyramid& pyramid)
 {
   for(std::size_t i = 0; i < pyramid.getNLevels(); ++i)
-    TePDIUtils::TeRaster2Geotiff(pyramid.getLevel(i), m_outputDir + "/" + m_inputImageFileName + "_pyramid_level_" + Te2String(i) + ".tif", false);
+    TePDIUtils::TeRaster2Geotiff(pyramid.getLevel(i).createRaster(), m_outputDir + "/" + m_inputImageFileName + "_pyramid_level_" + Te2String(i) + ".tif", false);
 }
 
 void FileOutputter::output(const MultiSeg& mseg, const std::size_t& currentLevel)
@@ -0,0 +1,224 @@
+/*  Copyright (C) 2014 National Institute For Space Research (INPE) - Brazil.
+
+    MultiSeg is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    MultiSeg is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with MultiSeg. See COPYING.
+ */
+
+/*!
+  \file LabelBuffer.cpp
+
+  \brief This class implements an in-memory image of region labels.
+
+  \author Douglas Uba <douglas@dpi.inpe.br>
+*/
+
+// MultiSeg
+#include "LabelBuffer.h"
+
+// TerraLib
+#include <terralib/image_processing/TePDIUtils.hpp>
+#include <terralib/kernel/TeAgnostic.h>
+#include <terralib/kernel/TeRaster.h>
+
+// STL
+#include <algorithm>
+
+const LabelBuffer::Label LabelBuffer::sm_invalidLabel;
+
+LabelBuffer::LabelBuffer()
+  : m_nLines(0),
+    m_nCols(0)
+{
+}
+
+LabelBuffer::~LabelBuffer()
+{
+}
+
+void LabelBuffer::reset(const TeRasterParams& params)
+{
+  m_params = params;
+  m_params.nBands(1);
+  m_params.setDataType(TeUNSIGNEDLONG);
+
+  m_nLines = params.nlines_;
+  m_nCols = params.ncols_;
+
+  m_parents.clear();
+
+  std::vector<Label>(m_nLines * m_nCols, sm_invalidLabel).swap(m_labels);
+
+  m_lines.resize(m_nLines);
+  for(std::size_t lin = 0; lin < m_nLines; ++lin)
+    m_lines[lin] = &m_labels[0] + lin * m_nCols;
+}
+
+const TeRasterParams& LabelBuffer::getParams() const
+{
+  return m_params;
+}
+
+void LabelBuffer::merge(const std::size_t& label, const std::size_t& into)
+{
+  assert(label != into);
+  assert(label < sm_invalidLabel);
+  assert(into < sm_invalidLabel);
+
+  std::size_t size = (std::max)(label, into) + 1;
+  if(m_parents.size() < size)
+    m_parents.resize(size, sm_invalidLabel);
+
+  // Only roots are merged. i.e. labels of live regions
+  assert(m_parents[label] == sm_invalidLabel);
+  assert(m_parents[into] == sm_invalidLabel);
+
+  m_parents[label] = static_cast<Label>(into);
+}
+
+void LabelBuffer::resolve()
+{
+  if(isResolved())
+    return;
+
+  // Consecutive pixels usually have the same label
+  Label last = sm_invalidLabel;
+  Label lastResolved = sm_invalidLabel;
+
+  for(std::size_t i = 0; i < m_labels.size(); ++i)
+  {
+    Label& label = m_labels[i];
+
+    if(label == last)
+    {
+      label = lastResolved;
+      continue;
+    }
+
+    last = label;
+
+    if(label < m_parents.size())
+      label = find(label);
+
+    lastResolved = label;
+  }
+
+  m_parents.clear();
+}
+
+LabelBuffer::Label LabelBuffer::find(Label label)
+{
+  Label root = label;
+  while(root < m_parents.size() && m_parents[root] != sm_invalidLabel)
+    root = m_parents[root];
+
+  // Path compression
+  while(label != root)
+  {
+    Label next = m_parents[label];
+    m_parents[label] = root;
+    label = next;
+  }
+
+  return root;
+}
+
+void LabelBuffer::upsample(const TeRasterParams& params, const std::size_t& nThreads)
+{
+  assert(isResolved());
+
+  const std::size_t nLines = params.nlines_;
+  const std::size_t nCols = params.ncols_;
+
+  assert(nLines <= m_nLines * 2 && nLines + 1 >= m_nLines * 2);
+  assert(nCols <= m_nCols * 2 && nCols + 1 >= m_nCols * 2);
+
+  std::vector<Label> labels(nLines * nCols);
+
+  // One strip of source lines for each thread
+  const int nStrips = static_cast<int>((std::max)(static_cast<std::size_t>(1), (std::min)(nThreads, m_nLines)));
+
+  // Each line is written on the two upsampled lines that it covers
+#ifdef _OPENMP
+  #pragma omp parallel for num_threads(nStrips) schedule(static, 1)
+#endif
+  for(int strip = 0; strip < nStrips; ++strip)
+  {
+    const std::size_t begin = m_nLines * strip / nStrips;
+    const std::size_t end = m_nLines * (strip + 1) / nStrips;
+
+    for(std::size_t lin = begin; lin < end; ++lin)
+    {
+      const Label* source = m_lines[lin];
+      Label* line = &labels[0] + lin * 2 * nCols;
+
+      for(std::size_t col = 0; col < nCols; ++col)
+        line[col] = source[col / 2];
+
+      // Odd number of lines: the last line covers only one upsampled line
+      if(lin * 2 + 1 < nLines)
+        std::copy(line, line + nCols, line + nCols);
+    }
+  }
+
+  m_params = params;
+  m_params.nBands(1);
+  m_params.setDataType(TeUNSIGNEDLONG);
+
+  m_nLines = nLines;
+  m_nCols = nCols;
+
+  m_labels.swap(labels);
+
+  m_lines.resize(m_nLines);
+  for(std::size_t lin = 0; lin < m_nLines; ++lin)
+    m_lines[lin] = &m_labels[0] + lin * m_nCols;
+}
+
+TePDITypes::TePDIRasterPtrType LabelBuffer::createRaster() const
+{
+  assert(isResolved());
+
+  TePDITypes::TePDIRasterPtrType raster;
+  TEAGN_TRUE_OR_THROW(TePDIUtils::TeAllocRAMRaster(m_params, raster), "Error creating the labelled image.");
+
+  for(std::size_t lin = 0; lin < m_nLines; ++lin)
+  {
+    const Label* line = m_lines[lin];
+
+    for(std::size_t col = 0; col < m_nCols; ++col)
+      raster->setElement(col, lin, static_cast<double>(line[col]));
+  }
+
+  return raster;
+}
+
+void LabelBuffer::read(const TePDITypes::TePDIRasterPtrType& raster)
+{
+  reset(raster->params());
+
+  double value = 0.0;
+  bool valueWasRead;
+
+  for(std::size_t lin = 0; lin < m_nLines; ++lin)
+  {
+    Label* line = m_lines[lin];
+
+    for(std::size_t col = 0; col < m_nCols; ++col)
+    {
+      valueWasRead = raster->getElement(col, lin, value);
+      assert(valueWasRead);
+
+      line[col] = static_cast<Label>(value);
+    }
+  }
+}
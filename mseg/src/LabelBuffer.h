@@ -0,0 +1,250 @@
+/*  Copyright (C) 2014 National Institute For Space Research (INPE) - Brazil.
+
+    MultiSeg is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    MultiSeg is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with MultiSeg. See COPYING.
+ */
+
+/*!
+  \file LabelBuffer.h
+
+  \brief This class implements an in-memory image of region labels.
+
+  \author Douglas Uba <douglas@dpi.inpe.br>
+*/
+
+#ifndef __MULTISEG_INTERNAL_LABELBUFFER_H
+#define __MULTISEG_INTERNAL_LABELBUFFER_H
+
+// MultiSeg
+#include "Config.h"
+
+// TerraLib
+#include <terralib/image_processing/TePDITypes.hpp>
+#include <terralib/kernel/TeRasterParams.h>
+
+// STL
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+/*!
+  \class LabelBuffer
+
+  \brief This class implements an in-memory image of region labels.
+
+  The labels are 32 bits unsigned integers stored on a contiguous buffer, line by line, and accessed
+  through line pointers. So, the region growing loops read and write the labels directly, without
+  virtual calls and without converting the values from/to double.
+
+  The buffer keeps the raster parameters of the image that it labels. A TerraLib raster is created
+  only when it is required. e.g. to output the labelled image.
+
+  The relabelling of the pixels of a merged region can be deferred: merge() only links the two labels
+  on a disjoint set forest, in O(1), and resolve() rewrites all pending labels in one linear pass.
+  The labels must be resolved before they are read.
+*/
+class MSEGEXPORT LabelBuffer
+{
+  public:
+
+    /*! \brief The label type. */
+    typedef unsigned int Label;
+
+    /*! \brief The label of the pixels that do not belong to any region. e.g. the invalidated pixels. */
+    static const Label sm_invalidLabel = 0xFFFFFFFF;
+
+    /*! \brief Default constructor. It creates an empty buffer. */
+    LabelBuffer();
+
+    /*! \brief Destructor. */
+    ~LabelBuffer();
+
+    /*!
+      \brief This method (re)allocates the buffer to the given raster geometry. All labels are invalidated.
+
+      \param params The raster parameters. Only the geometry (lines, columns and bounding box) is considered.
+    */
+    void reset(const TeRasterParams& params);
+
+    /*!
+      \brief This method returns the raster parameters of the labelled image.
+
+      \return The raster parameters of the labelled image.
+    */
+    const TeRasterParams& getParams() const;
+
+    /*!
+      \brief This method returns the number of lines.
+
+      \return The number of lines.
+    */
+    std::size_t getNLines() const;
+
+    /*!
+      \brief This method returns the number of columns.
+
+      \return The number of columns.
+    */
+    std::size_t getNCols() const;
+
+    /*!
+      \brief This method returns the labels of the given line.
+
+      \param lin The line.
+
+      \return The getNCols() labels of the given line.
+    */
+    Label* getLine(const std::size_t& lin);
+
+    /*!
+      \brief This method returns the labels of the given line.
+
+      \param lin The line.
+
+      \return The getNCols() labels of the given line.
+    */
+    const Label* getLine(const std::size_t& lin) const;
+
+    /*!
+      \brief This method returns the label of the given pixel.
+
+      \param lin The pixel line.
+      \param col The pixel column.
+
+      \return The label of the given pixel.
+    */
+    Label get(const std::size_t& lin, const std::size_t& col) const;
+
+    /*!
+      \brief This method sets the label of the given pixel.
+
+      \param lin   The pixel line.
+      \param col   The pixel column.
+      \param label The label. i.e. a region identifier or sm_invalidLabel.
+    */
+    void set(const std::size_t& lin, const std::size_t& col, const std::size_t& label);
+
+    /*!
+      \brief This method defers the relabelling of all pixels labelled as label to the label into.
+
+      \param label The label that will be replaced. e.g. the identifier of a merged region.
+      \param into  The new label. e.g. the identifier of the region that absorbed the merged one.
+
+      \note The pixels are relabelled by resolve().
+    */
+    void merge(const std::size_t& label, const std::size_t& into);
+
+    /*!
+      \brief This method returns if there are no deferred relabellings.
+
+      \return It returns true if there are no deferred relabellings and false otherwise.
+    */
+    bool isResolved() const;
+
+    /*! \brief This method applies all deferred relabellings in one pass over the labels. */
+    void resolve();
+
+    /*!
+      \brief This method upsamples the labels by 2, through the nearest neighbour. i.e. the pixel (lin, col) gets the label of (lin / 2, col / 2).
+
+      \param params   The raster parameters of the upsampled image. e.g. the next finer pyramid level. Its number of lines
+                      (columns) must be the double of the current one, or one less.
+      \param nThreads The number of threads that share the lines. It is effective only with OpenMP support.
+
+      \note The labels must be resolved.
+    */
+    void upsample(const TeRasterParams& params, const std::size_t& nThreads = 1);
+
+    /*!
+      \brief This method creates a RAM raster (TeUNSIGNEDLONG) with the labels.
+
+      \return A new raster with the labels.
+    */
+    TePDITypes::TePDIRasterPtrType createRaster() const;
+
+    /*!
+      \brief This method (re)allocates the buffer to the geometry of the given raster and reads its labels.
+
+      \param raster The labelled raster. The first band is considered.
+    */
+    void read(const TePDITypes::TePDIRasterPtrType& raster);
+
+  private:
+
+    /*! \brief This method returns the final label of the given label, compressing the followed path. */
+    Label find(Label label);
+
+    /*! \brief No copy allowed. */
+    LabelBuffer(const LabelBuffer& rhs);
+
+    /*! \brief No copy allowed. */
+    LabelBuffer& operator=(const LabelBuffer& rhs);
+
+  private:
+
+    TeRasterParams m_params;       //!< The raster parameters of the labelled image.
+    std::size_t m_nLines;          //!< The number of lines.
+    std::size_t m_nCols;           //!< The number of columns.
+    std::vector<Label> m_labels;   //!< The labels, line by line.
+    std::vector<Label*> m_lines;   //!< The first label of each line.
+    std::vector<Label> m_parents;  //!< The deferred relabellings. i.e. the parent of each label on the disjoint set forest or sm_invalidLabel.
+};
+
+inline std::size_t LabelBuffer::getNLines() const
+{
+  return m_nLines;
+}
+
+inline std::size_t LabelBuffer::getNCols() const
+{
+  return m_nCols;
+}
+
+inline bool LabelBuffer::isResolved() const
+{
+  return m_parents.empty();
+}
+
+inline LabelBuffer::Label* LabelBuffer::getLine(const std::size_t& lin)
+{
+  assert(lin < m_nLines);
+  assert(isResolved());
+  return m_lines[lin];
+}
+
+inline const LabelBuffer::Label* LabelBuffer::getLine(const std::size_t& lin) const
+{
+  assert(lin < m_nLines);
+  assert(isResolved());
+  return m_lines[lin];
+}
+
+inline LabelBuffer::Label LabelBuffer::get(const std::size_t& lin, const std::size_t& col) const
+{
+  assert(lin < m_nLines);
+  assert(col < m_nCols);
+  assert(isResolved());
+
+  return m_lines[lin][col];
+}
+
+inline void LabelBuffer::set(const std::size_t& lin, const std::size_t& col, const std::size_t& label)
+{
+  assert(lin < m_nLines);
+  assert(col < m_nCols);
+  assert(label <= sm_invalidLabel);
+
+  m_lines[lin][col] = static_cast<Label>(label);
+}
+
+#endif // __MULTISEG_INTERNAL_LABELBUFFER_H
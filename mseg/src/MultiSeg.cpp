@@ -27,12 +27,14 @@
 #include "EuclideanMerger.h"
 #include "MultiSeg.h"
 #include "OpticalCartoonMerger.h"
+#include "OpticalTextureMerger.h"
 #include "RadarCartoonMerger.h"
+#include "RadarTextureMerger.h"
 #include "Region.h"
+#include "RegionPool.h"
 #include "Utils.h"
 
 // TerraLib PDI
-#include <terralib/image_processing/TePDIStatistic.hpp>
 #include <terralib/image_processing/TePDIUtils.hpp>
 
 // Boost
@@ -47,18 +49,31 @@
 #include <fstream>
 #include <limits>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 MultiSeg::MultiSeg()
   : m_cv(TeMAXFLOAT),
+    m_regionGrowingStrategy(Passes),
+    m_regionPool(0),
     m_merger(new EuclideanMerger),
+    m_closestEpoch(1),
     m_similarityIncreaseStep(0),
     m_enableMutualBestFitting(true),
     m_growUntilStop(true),
-    m_nSamples(std::string::npos),
     m_considerRegionVsRegion(true),
     m_currentLevel(0),
     m_pyramid(0),
     m_outputPyramid(false),
-    m_notifyIntermediateResults(false)
+    m_notifyIntermediateResults(false),
+    m_deferLabelUpdates(true),
+    m_trackPixelRuns(true),
+    m_cacheClosestRegions(true),
+    m_nThreads(1),
+    m_pyramidMemoryBudget(0),
+    m_trackHigherMoments(false),
+    m_trackCooccurrences(false)
 {
 }
 
@@ -66,12 +81,11 @@ MultiSeg::~MultiSeg()
 {
   delete m_merger;
 
-  std::map<std::size_t, Region*>::iterator it;
-  for(it = m_regions.begin(); it != m_regions.end(); ++it)
-    delete it->second;
-
   m_regions.clear();
 
+  // Releases all regions at once
+  delete m_regionPool;
+
   delete m_pyramid;
 }
 
@@ -124,11 +138,8 @@ bool MultiSeg::CheckParameters(const TePDIParameters& params) const
     double cv; // Need Coefficient of variation.
     TEAGN_TRUE_OR_RETURN(params.GetParameter("cv", cv), "Missing parameter: cv");
     
-    if(type == Optical)
-    {
-      double confidenceLevel; // Need confidence_level
-      TEAGN_TRUE_OR_RETURN(params.GetParameter("confidence_level", confidenceLevel), "Missing parameter: confidence_level");
-    }
+    double confidenceLevel; // Need confidence_level
+    TEAGN_TRUE_OR_RETURN(params.GetParameter("confidence_level", confidenceLevel), "Missing parameter: confidence_level");
   }
 
   return true;
@@ -139,7 +150,7 @@ const TePDITypes::TePDIRasterPtrType& MultiSeg::getInputImage() const
   return m_inputImage;
 }
 
-const std::map<std::size_t, Region*>& MultiSeg::getRegions() const
+const RegionTable& MultiSeg::getRegions() const
 {
   return m_regions;
 }
@@ -169,6 +180,36 @@ void MultiSeg::notifyIntermediateResults(bool on)
   m_notifyIntermediateResults = on;
 }
 
+void MultiSeg::deferLabelUpdates(bool on)
+{
+  m_deferLabelUpdates = on;
+}
+
+void MultiSeg::trackPixelRuns(bool on)
+{
+  m_trackPixelRuns = on;
+}
+
+void MultiSeg::cacheClosestRegions(bool on)
+{
+  m_cacheClosestRegions = on;
+}
+
+void MultiSeg::setNumberOfThreads(const std::size_t& nThreads)
+{
+  m_nThreads = nThreads;
+}
+
+void MultiSeg::setPyramidMemoryBudget(const std::size_t& bytes)
+{
+  m_pyramidMemoryBudget = bytes;
+}
+
+void MultiSeg::setPyramidCacheDirectory(const std::string& directory)
+{
+  m_pyramidCacheDirectory = directory;
+}
+
 void MultiSeg::ResetState(const TePDIParameters& /*params*/)
 {
   // To fix seeds
@@ -182,45 +223,98 @@ bool MultiSeg::RunImplementation()
 {
   initializeParameters();
 
+  // Generates the pyramid hierarchy. Note: the levels are built on demand and their statistics are computed while they are built
+  m_pyramid = new Pyramid(m_inputImage, m_levels, m_bands, progress_enabled_, getNumberOfThreads());
+  m_pyramid->setMemoryBudget(m_pyramidMemoryBudget);
+  m_pyramid->setCacheDirectory(m_pyramidCacheDirectory);
+
+  if(m_imageType == Radar)
+  {
+    // Must be set before the statistics are requested: amplitude and dB values are converted to intensity while the base level is read
+    m_pyramid->setInputFormat(m_imageRadarFormat);
+
+    /* Converts similarity (dB) to Intensity */
+
+    double minMean = TeMAXFLOAT;
+    for(std::size_t i = 0; i < m_bands.size(); ++i)
+      minMean = (std::min)(m_pyramid->getMean(0, i), minMean);
+
+    double db = m_similarity;
+    m_similarity = minMean * (std::pow(10.0, db / 10.0) - 1.0);
+
+    /* end-Converts similarity (dB) to Intensity */
+  }
+
+  // Segments the levels through the passes instantiated for the merger. Note: the merger was created by initializeMerger()
+  if(m_imageType == Radar && m_imageModel == Cartoon)
+    segment<RadarCartoonMerger>();
+  else if(m_imageType == Optical && m_imageModel == Cartoon)
+    segment<OpticalCartoonMerger>();
+  else if(m_imageType == Radar && m_imageModel == Texture)
+    segment<RadarTextureMerger>();
+  else
+    segment<OpticalTextureMerger>();
+
+  // In the minimum area process it is always valid
+  m_considerRegionVsRegion = true;
+
+  delete m_merger;
+  m_merger = new EuclideanMerger;
+
+  // The euclidean merger does not read the texture statistics
+  m_trackHigherMoments = false;
+  m_trackCooccurrences = false;
+  m_boundaries.clear();
+
+  // Process the small regions. Note: Here uses the euclidean merger
+  if(m_merger->isStrictMode())
+    processSmallRegions<EuclideanMerger, true>();
+  else
+    processSmallRegions<EuclideanMerger, false>();
+
+  // Notifies the final results
+  notifyResult();
+
+  std::cout << "--- Segmentation completed! # Number of Regions: " << m_regions.size() << std::endl << std::endl;
+
+  return true;
+}
+
+template<class Merger> void MultiSeg::segment()
+{
+  assert(dynamic_cast<Merger*>(m_merger));
+
+  if(m_merger->isStrictMode())
+    segment<Merger, true>();
+  else
+    segment<Merger, false>();
+}
+
+template<class Merger, bool strict> void MultiSeg::segment()
+{
   // To region growing
   bool useRandomSeeds = true;
 
   if(m_levels == 0)
   {
     // One level!
-    m_pyramid = new Pyramid(m_inputImage, m_levels, m_bands, progress_enabled_);
+
+    const PixelBuffer& image = m_pyramid->getLevel(0);
 
     // Initializes the labelled image
-    TeRasterParams params = m_inputImage->params();
-    params.nBands(1);
-    params.setDataType(TeUNSIGNEDLONG);
-    TEAGN_TRUE_OR_THROW(TePDIUtils::TeAllocRAMRaster(params, m_labelledImage), "Error creating the level labelled image.");
+    m_labels.reset(image.getParams());
 
     // Initializes the regions
-    initializeRegions(m_inputImage);
+    initializeRegions(image);
 
     // Updates the thresholds
     updateThresholds(m_levels);
 
     /* Region Growing */
-    executeRegionGrowing(m_regions, useRandomSeeds);
-
-    /* Minimum area */
-
-    // In the minimum area process it is always valid
-    m_considerRegionVsRegion = true;
-
-    delete m_merger;
-    m_merger = new EuclideanMerger;
-
-    // Process the small regions. Note: Here uses the euclidean merger
-    processSmallRegions();
+    executeRegionGrowing<Merger, strict>(m_regions, useRandomSeeds);
   }
   else
   {
-    // Generates the pyramid hierarchy
-    m_pyramid = new Pyramid(m_inputImage, m_levels, m_bands, progress_enabled_);
-
     // Output the pyramid
     if(m_outputPyramid)
     {
@@ -229,13 +323,10 @@ bool MultiSeg::RunImplementation()
     }
 
     // Gets the lowest level
-    TePDITypes::TePDIRasterPtrType lowestLevel = m_pyramid->getLevel(m_levels);
+    const PixelBuffer& lowestLevel = m_pyramid->getLevel(m_levels);
 
     // Initializes the labelled image
-    TeRasterParams params = lowestLevel->params();
-    params.nBands(1);
-    params.setDataType(TeUNSIGNEDLONG);
-    TEAGN_TRUE_OR_THROW(TePDIUtils::TeAllocRAMRaster(params, m_labelledImage), "Error creating the lowest level labelled image.");
+    m_labels.reset(lowestLevel.getParams());
 
     // Initializes the regions
     initializeRegions(lowestLevel);
@@ -245,7 +336,7 @@ bool MultiSeg::RunImplementation()
 
     /* First Region Growing */
     m_considerRegionVsRegion = true;
-    executeRegionGrowing(m_regions, useRandomSeeds);
+    executeRegionGrowing<Merger, strict>(m_regions, useRandomSeeds);
 
     // Notifies the intermediate results
     if(m_notifyIntermediateResults)
@@ -262,13 +353,11 @@ bool MultiSeg::RunImplementation()
       m_pyramid->releaseLevel(i + 1);
 
       // Gets the next pyramid level
-      TePDITypes::TePDIRasterPtrType inputImageCurrentLevel = m_pyramid->getLevel(i);
-
-      // Resizes the labelled image
-      m_labelledImage = Pyramid::resize(m_labelledImage, inputImageCurrentLevel->params());
+      const PixelBuffer& inputImageCurrentLevel = m_pyramid->getLevel(i);
 
-      // Resizes the regions
-      resizeRegions();
+      // Resizes the labelled image and the regions
+      m_labels.resolve();
+      resizeRegions(inputImageCurrentLevel.getParams());
 
       // Updates the thresholds
       updateThresholds(i);
@@ -277,7 +366,7 @@ bool MultiSeg::RunImplementation()
       updateRegionStatistics(inputImageCurrentLevel);
 
       /* Border adjustment */
-      adjustRegionBorders(inputImageCurrentLevel); // Need review!
+      adjustRegionBorders<Merger>(inputImageCurrentLevel); // Need review!
 
       // Updating the region statistics...
       updateRegionStatistics(inputImageCurrentLevel);
@@ -285,20 +374,22 @@ bool MultiSeg::RunImplementation()
       if(i != 0 || splitLastLevel)
       {
         /* Split Regions */
-        std::map<std::size_t, Region*> newRegions;
-        splitRegions(inputImageCurrentLevel, newRegions);
+        RegionTable newRegions;
+        splitRegions<Merger, strict>(inputImageCurrentLevel, newRegions);
 
         /* Region Growing of the new regions */
         m_considerRegionVsRegion = false;
-        executeRegionGrowing(newRegions, useRandomSeeds);
+        executeRegionGrowing<Merger, strict>(newRegions, useRandomSeeds);
       }
 
       /* Region Growing to regions merge */
       m_considerRegionVsRegion = true;
-      executeRegionGrowing(m_regions, useRandomSeeds);
+      executeRegionGrowing<Merger, strict>(m_regions, useRandomSeeds);
 
-      // Updating the region statistics...
-      updateRegionStatistics(inputImageCurrentLevel);
+      // Updating the region statistics... The merges keep them up to date and the next level recomputes them from
+      // its own image. So, a new pass is only needed to output the intermediate results and on the last level
+      if(i == 0 || m_notifyIntermediateResults)
+        updateRegionStatistics(inputImageCurrentLevel);
 
       // Notifies the intermediate results
       if(i != 0 && m_notifyIntermediateResults)
@@ -306,23 +397,7 @@ bool MultiSeg::RunImplementation()
 
       std::cout << "--- Level " <<  m_currentLevel << " completed! # Number of Regions: " << m_regions.size() << std::endl;
     }
-
-    // In the minimum area process it is always valid
-    m_considerRegionVsRegion = true;
-
-    delete m_merger;
-    m_merger = new EuclideanMerger;
-
-    // Process the small regions. Note: Here uses the euclidean merger
-    processSmallRegions();
   }
-
-  // Notifies the final results
-  notifyResult();
-
-  std::cout << "--- Segmentation completed! # Number of Regions: " << m_regions.size() << std::endl << std::endl;
-
-  return true;
 }
 
 void MultiSeg::initializeParameters()
@@ -352,54 +427,16 @@ void MultiSeg::initializeParameters()
   params_.GetParameter("similarity", m_similarity);
   params_.GetParameter("min_area", m_minArea);
 
+  // Passes or PriorityQueue? (optional)
+  if(!params_.GetParameter("region_growing_strategy", m_regionGrowingStrategy))
+    m_regionGrowingStrategy = Passes;
+
   if(m_imageType == Radar)
   {
     // So, the input image is Radar. Which is the format?
     params_.GetParameter("image_radar_format", m_imageRadarFormat); // Intensity, Amplitude or dB?
-    if(m_imageRadarFormat != Intensity)
-    {
-      if(m_imageRadarFormat == Amplitude)
-      {
-        TePDITypes::TePDIRasterPtrType intensityImage = Utils::Amplitude2Intensity(m_inputImage);
-        m_inputImage = intensityImage;
-      }
-      else
-      {
-        // TODO: Utils::dB2Intensity method!
-      }
-    }
-
-    /* Converts similarity (dB) to Intensity */
-
-    // Statistic Algorithm
-    TePDIParameters statParams;
-
-    // Input Raster & input bands
-    TePDITypes::TePDIRasterVectorType rasters;
-    std::vector<int> bands;
 
-    for(std::size_t i = 0; i < m_bands.size(); ++i)
-    {
-      rasters.push_back(m_inputImage);
-      bands.push_back(m_bands[i]);
-    }
-
-    statParams.SetParameter("rasters", rasters);
-    statParams.SetParameter("bands", bands);
-
-    // Calculates the mean of image
-    TePDIStatistic stat;
-    stat.ToggleProgInt(false);
-    stat.Reset(statParams);
-
-    double minMean = TeMAXFLOAT;
-    for(std::size_t i = 0; i < m_bands.size(); ++i)
-      minMean = (std::min)(stat.getMean(i), minMean);
-
-    double db = m_similarity;
-    m_similarity = minMean * (std::pow(10.0, db / 10.0) - 1.0);
-    
-    /* end-Converts similarity (dB) to Intensity */
+    // Note: amplitude and dB values, and the similarity (dB), are converted to intensity. See RunImplementation()
   }
 
   if(m_imageType == Radar && m_imageModel == Cartoon)
@@ -417,8 +454,7 @@ void MultiSeg::initializeParameters()
   if((m_imageType == Radar && m_imageModel == Texture) || m_imageType == Optical)
   {
     params_.GetParameter("cv", m_cv);
-    if(m_imageType == Optical)
-      params_.GetParameter("confidence_level", m_confidenceLevel);
+    params_.GetParameter("confidence_level", m_confidenceLevel);
   }
 
   initializeMerger();
@@ -438,48 +474,75 @@ void MultiSeg::initializeMerger()
     m_merger = new OpticalCartoonMerger;
   }
 
-  // TODO: [Radar + Texture] / [Optical + Texture]
+  if(m_imageType == Radar && m_imageModel == Texture)
+  {
+    delete m_merger;
+    m_merger = new RadarTextureMerger;
+  }
+
+  if(m_imageType == Optical && m_imageModel == Texture)
+  {
+    delete m_merger;
+    m_merger = new OpticalTextureMerger;
+  }
 
   m_merger->setParam("confidence_level", m_confidenceLevel);
 }
 
-void MultiSeg::initializeRegions(const TePDITypes::TePDIRasterPtrType& image)
+void MultiSeg::initializeRegions(const PixelBuffer& image)
 {
   int nBands = m_bands.size();
-  int nLines = image->params().nlines_;
-  int nCols  = image->params().ncols_;
+  int nLines = image.getNLines();
+  int nCols  = image.getNCols();
+
+  assert(image.getNBands() == m_bands.size());
 
   std::vector<double> pixel;
   pixel.resize(nBands, 0.0);
 
-  double value = 0.0;
-  bool valueWasRead;
-
   std::size_t nRegions = 0;
   TePDIPIManager progress("Initializing Regions", nLines * nCols, progress_enabled_);
 
+  // Here, each pixel is a region
+  m_regions.reserve(nLines * nCols);
+
+  // The texture statistics are tracked only if the merger reads them
+  m_trackHigherMoments = m_merger->usesHigherMoments();
+  m_trackCooccurrences = m_merger->usesCooccurrences();
+
+  if(m_trackCooccurrences)
+    m_boundaries.reset(nBands);
+  else
+    m_boundaries.clear();
+
+  delete m_regionPool;
+  m_regionPool = new RegionPool(nBands, (std::min)(static_cast<std::size_t>(nLines * nCols), static_cast<std::size_t>(65536)),
+                                m_trackHigherMoments, m_trackCooccurrences);
+
+  // 8 or 16 bits images: the pixels are compared through integer differences. Note: the pyramid levels keep the data types, except the converted radar values
+  bool isConverted = m_imageType == Radar && m_imageRadarFormat != Intensity;
+  m_merger->setParam("integer_pixels", !isConverted && Utils::IsSmallIntegerImage(m_inputImage, m_bands) ? 1.0 : 0.0);
+
   for(int lin = 0; lin < nLines; ++lin)
   {
+    const PixelBuffer::Value* line = image.getLine(lin);
+
     for(int col = 0; col < nCols; ++col)
     {
       for(int b = 0; b < nBands; ++b)
-      {
-        valueWasRead = image->getElement(col, lin, value, m_bands[b]);
-        assert(valueWasRead);
-        pixel[b] = value;
-      }
+        pixel[b] = line[col * nBands + b];
 
       // Generates an id for the new region
       std::size_t id = Utils::GenerateId(lin, col, nCols);
 
       // Initializing a new region
-      Region* region = new Region(id, pixel, lin, col);
+      Region* region = m_regionPool->create(id, pixel, lin, col);
 
       // Indexing...
-      m_regions[id] = region;
+      m_regions.insert(region);
 
       // First, each region is a pixel
-      m_labelledImage->setElement(col, lin, id);
+      m_labels.set(lin, col, id);
 
       // Building the neighborhood information
       if(lin)
@@ -489,6 +552,9 @@ void MultiSeg::initializeRegions(const TePDITypes::TePDIRasterPtrType& image)
         {
           region->addNeighbour(neighbour);
           neighbour->addNeighbour(region);
+
+          if(m_trackCooccurrences)
+            addBoundaryPair(image, lin, col, id, lin - 1, col, neighbour->getId());
         }
       }
 
@@ -499,6 +565,9 @@ void MultiSeg::initializeRegions(const TePDITypes::TePDIRasterPtrType& image)
         {
           region->addNeighbour(neighbour);
           neighbour->addNeighbour(region);
+
+          if(m_trackCooccurrences)
+            addBoundaryPair(image, lin, col, id, lin, col - 1, neighbour->getId());
         }
       }
 
@@ -507,7 +576,7 @@ void MultiSeg::initializeRegions(const TePDITypes::TePDIRasterPtrType& image)
   }
 }
 
-void MultiSeg::executeRegionGrowing(std::map<std::size_t, Region*>& regions, bool useRandomSeeds, std::size_t maxIterations)
+template<class Merger, bool strict> void MultiSeg::executeRegionGrowing(RegionTable& regions, bool useRandomSeeds, std::size_t maxIterations)
 {
   std::size_t iteration = 0;
   std::size_t noMergeIterations = 0;
@@ -516,12 +585,24 @@ void MultiSeg::executeRegionGrowing(std::map<std::size_t, Region*>& regions, boo
   double threshold = m_currentSimilarity / (double)(m_similarityIncreaseStep + 1);
   m_merger->setParam("euclidean_distance_threshold", threshold);
 
+  // The regions, the merger and its parameters may have changed since the last region growing
+  ++m_closestEpoch;
+
   TePDIPIManager progress("Merging Regions - Level " + Te2String(m_currentLevel), maxIterations, progress_enabled_);
 
   while(true)
   {
-    useRandomSeeds == false ? mergedRegions = mergeRegions(regions) :
-    /* else */                mergedRegions = mergeRegionsRandomly(regions);
+    if(m_regionGrowingStrategy == PriorityQueue)
+    {
+      // The queue is exhausted, so another round with the same threshold would not merge anything
+      mergeRegionsByPriority<Merger, strict>(regions);
+      mergedRegions = 0;
+    }
+    else
+    {
+      useRandomSeeds == false ? mergedRegions = mergeRegions<Merger, strict>(regions) :
+      /* else */                mergedRegions = mergeRegionsRandomly<Merger, strict>(regions);
+    }
 
     ++iteration;
 
@@ -539,32 +620,39 @@ void MultiSeg::executeRegionGrowing(std::map<std::size_t, Region*>& regions, boo
 
       threshold += (((double)m_currentSimilarity) / ((double)(m_similarityIncreaseStep + 1)));
       m_merger->setParam("euclidean_distance_threshold", threshold);
+
+      // The predicates depend on the threshold
+      ++m_closestEpoch;
     }
   }
 
   m_merger->setParam("euclidean_distance_threshold", m_currentSimilarity);
+
+  ++m_closestEpoch;
 }
 
-std::size_t MultiSeg::mergeRegions(std::map<std::size_t, Region*>& regions)
+template<class Merger, bool strict> std::size_t MultiSeg::mergeRegions(RegionTable& regions)
 {
+  const Merger* merger = static_cast<const Merger*>(m_merger);
+
   // The number of merged regions
   std::size_t mergedRegions = 0;
 
-  std::map<std::size_t, Region*>::iterator regionsIt = regions.begin();
-  std::map<std::size_t, Region*>::iterator regionsItEnd = regions.end();
+  RegionTable::iterator regionsIt = regions.begin();
+  RegionTable::iterator regionsItEnd = regions.end();
 
   while(regionsIt != regionsItEnd) // for each region
   {
     // The current region
-    Region* currentRegion = regionsIt->second;
+    Region* currentRegion = *regionsIt;
 
     // Try gets the closest neighbour region
-    Region* closestNeighbour = getClosestRegion(currentRegion);
+    Region* closestNeighbour = getClosestRegion<Merger, strict>(currentRegion);
 
     // Is necessary mutual best fitting?
     if(closestNeighbour != 0 && m_enableMutualBestFitting)
     {
-      Region* backClosestNeighbour = getClosestRegion(closestNeighbour);
+      Region* backClosestNeighbour = getClosestRegion<Merger, strict>(closestNeighbour);
       if(backClosestNeighbour == 0 || (backClosestNeighbour != currentRegion))
         closestNeighbour = 0;
     }
@@ -572,15 +660,15 @@ std::size_t MultiSeg::mergeRegions(std::map<std::size_t, Region*>& regions)
     // If the minimum dissimilarity neighbour was found it will be merged
     if(closestNeighbour != 0)
     {
-      m_merger->merge(currentRegion, closestNeighbour);
+      updateLabelledImage(currentRegion, closestNeighbour);
 
-      updateNeighborhoodAfterMerge(currentRegion, closestNeighbour);
+      merger->Merger::merge(currentRegion, closestNeighbour);
 
-      updateLabelledImage(currentRegion, closestNeighbour);
+      updateNeighborhoodAfterMerge(currentRegion, closestNeighbour);
 
       std::size_t idToRemove = closestNeighbour->getId();
 
-      delete closestNeighbour;
+      m_regionPool->destroy(closestNeighbour);
 
       regions.erase(idToRemove);
 
@@ -598,20 +686,22 @@ std::size_t MultiSeg::mergeRegions(std::map<std::size_t, Region*>& regions)
   return mergedRegions;
 }
 
-std::size_t MultiSeg::mergeRegionsRandomly(std::map<std::size_t, Region*>& regions)
+template<class Merger, bool strict> std::size_t MultiSeg::mergeRegionsRandomly(RegionTable& regions)
 {
+  const Merger* merger = static_cast<const Merger*>(m_merger);
+
   // The number of merged regions
   std::size_t mergedRegions = 0;
 
-  std::map<std::size_t, Region*>::iterator regionsIt = regions.begin();
-  std::map<std::size_t, Region*>::iterator regionsItEnd = regions.end();
+  RegionTable::iterator regionsIt = regions.begin();
+  RegionTable::iterator regionsItEnd = regions.end();
 
   // Random ids vector
   std::vector<std::size_t> ids(regions.size(), 0);
   std::size_t index = 0;
   while(regionsIt != regionsItEnd)
   {
-    ids[index] = regionsIt->second->getId();
+    ids[index] = (*regionsIt)->getId();
     ++index;
     ++regionsIt;
   }
@@ -621,22 +711,20 @@ std::size_t MultiSeg::mergeRegionsRandomly(std::map<std::size_t, Region*>& regio
 
   for(std::size_t i = 0; i < ids.size(); ++i)
   {
-    std::map<std::size_t, Region*>::iterator it = regions.find(ids[i]);
-    if(it == regions.end())
-      continue;
-
     // The current region
-    Region* currentRegion = regions[ids[i]];
+    Region* currentRegion = regions.get(ids[i]);
+    if(currentRegion == 0)
+      continue;
 
     while(true)
     {
       // Try gets the closest neighbour region
-      Region* closestNeighbour = getClosestRegion(currentRegion);
+      Region* closestNeighbour = getClosestRegion<Merger, strict>(currentRegion);
 
       // Is necessary mutual best fitting?
       if(closestNeighbour != 0 && m_enableMutualBestFitting)
       {
-        Region* backClosestNeighbour = getClosestRegion(closestNeighbour);
+        Region* backClosestNeighbour = getClosestRegion<Merger, strict>(closestNeighbour);
         if(backClosestNeighbour == 0 || (backClosestNeighbour != currentRegion))
           closestNeighbour = 0;
       }
@@ -644,15 +732,15 @@ std::size_t MultiSeg::mergeRegionsRandomly(std::map<std::size_t, Region*>& regio
       // If the minimum dissimilarity neighbour was found it will be merged
       if(closestNeighbour != 0)
       {
-        m_merger->merge(currentRegion, closestNeighbour);
+        updateLabelledImage(currentRegion, closestNeighbour);
 
-        updateNeighborhoodAfterMerge(currentRegion, closestNeighbour);
+        merger->Merger::merge(currentRegion, closestNeighbour);
 
-        updateLabelledImage(currentRegion, closestNeighbour);
+        updateNeighborhoodAfterMerge(currentRegion, closestNeighbour);
 
         std::size_t idToRemove = closestNeighbour->getId();
 
-        delete closestNeighbour;
+        m_regionPool->destroy(closestNeighbour);
 
         regions.erase(idToRemove);
 
@@ -671,18 +759,113 @@ std::size_t MultiSeg::mergeRegionsRandomly(std::map<std::size_t, Region*>& regio
   return mergedRegions;
 }
 
-std::size_t MultiSeg::mergeSmallRegions()
+template<class Merger, bool strict> std::size_t MultiSeg::mergeRegionsByPriority(RegionTable& regions)
 {
+  const Merger* merger = static_cast<const Merger*>(m_merger);
+
   // The number of merged regions
   std::size_t mergedRegions = 0;
 
-  std::map<std::size_t, Region*>::iterator regionsIt = m_regions.begin();
-  std::map<std::size_t, Region*>::iterator regionsItEnd = m_regions.end();
+  if(regions.empty())
+    return mergedRegions;
+
+  // Note: the merge epoch of a region is increased each time its closest neighbour must be recomputed. The queue is always drained, so the epochs need no reset
+  assert(m_candidates.empty());
+
+  // Queues the candidate merge of each region
+  RegionTable::iterator regionsIt = regions.begin();
+  RegionTable::iterator regionsItEnd = regions.end();
+  while(regionsIt != regionsItEnd)
+  {
+    pushMergeCandidate<Merger, strict>(*regionsIt, regions);
+    ++regionsIt;
+  }
+
+  while(!m_candidates.empty())
+  {
+    MergeCandidate candidate = m_candidates.top();
+    m_candidates.pop();
+
+    // Lazy invalidation: the region was merged or it changed after the candidate was queued
+    Region* currentRegion = regions.get(candidate.m_regionId);
+    if(currentRegion == 0 || candidate.m_epoch != currentRegion->getMergeEpoch())
+      continue;
+
+    Region* closestNeighbour = candidate.m_closest;
+
+    // Is necessary mutual best fitting?
+    if(m_enableMutualBestFitting && getClosestRegion<Merger, strict>(closestNeighbour) != currentRegion)
+      continue;
+
+    updateLabelledImage(currentRegion, closestNeighbour);
+
+    merger->Merger::merge(currentRegion, closestNeighbour);
+
+    updateNeighborhoodAfterMerge(currentRegion, closestNeighbour);
+
+    std::size_t idToRemove = closestNeighbour->getId();
+
+    m_regionPool->destroy(closestNeighbour);
+
+    regions.erase(idToRemove);
+
+    m_regions.erase(idToRemove);
+
+    ++mergedRegions;
+
+    // Only the closest neighbours of the grown region and of its neighbours may have changed
+    pushMergeCandidate<Merger, strict>(currentRegion, regions);
+
+    Neighbourhood::const_iterator neighbourIt = currentRegion->getNeighbours().begin();
+    Neighbourhood::const_iterator neighbourItEnd = currentRegion->getNeighbours().end();
+    while(neighbourIt != neighbourItEnd)
+    {
+      pushMergeCandidate<Merger, strict>(*neighbourIt, regions);
+      ++neighbourIt;
+    }
+  }
+
+  return mergedRegions;
+}
+
+template<class Merger, bool strict> void MultiSeg::pushMergeCandidate(Region* region, const RegionTable& regions)
+{
+  assert(region);
+
+  // Only the regions of the given table start a merge
+  if(regions.get(region->getId()) != region)
+    return;
+
+  // Invalidates the queued candidate of the region, if any
+  std::size_t epoch = region->increaseMergeEpoch();
+
+  Region* closestNeighbour = getClosestRegion<Merger, strict>(region);
+  if(closestNeighbour == 0)
+    return;
+
+  MergeCandidate candidate;
+  candidate.m_distance = m_merger->getSquaredEuclideanDistance(region, closestNeighbour);
+  candidate.m_regionId = region->getId();
+  candidate.m_epoch = epoch;
+  candidate.m_closest = closestNeighbour;
+
+  m_candidates.push(candidate);
+}
+
+template<class Merger, bool strict> std::size_t MultiSeg::mergeSmallRegions()
+{
+  const Merger* merger = static_cast<const Merger*>(m_merger);
+
+  // The number of merged regions
+  std::size_t mergedRegions = 0;
+
+  RegionTable::iterator regionsIt = m_regions.begin();
+  RegionTable::iterator regionsItEnd = m_regions.end();
 
   while(regionsIt != regionsItEnd) // for each region
   {
     // The current region
-    Region* currentRegion = regionsIt->second;
+    Region* currentRegion = *regionsIt;
 
     // Is this a small region ?
     if(currentRegion->getSize() > m_minArea)
@@ -692,7 +875,7 @@ std::size_t MultiSeg::mergeSmallRegions()
     }
 
     // Gets the closest neighbour region
-    Region* closestNeighbour = getClosestRegion(currentRegion, true);
+    Region* closestNeighbour = getClosestRegion<Merger, strict>(currentRegion, true);
 
     // If the minimum dissimilarity neighbour was not found, continue...
     if(closestNeighbour == 0)
@@ -701,15 +884,15 @@ std::size_t MultiSeg::mergeSmallRegions()
       continue;
     }
 
-    m_merger->merge(closestNeighbour, currentRegion);
+    updateLabelledImage(closestNeighbour, currentRegion);
 
-    updateNeighborhoodAfterMerge(closestNeighbour, currentRegion);
+    merger->Merger::merge(closestNeighbour, currentRegion);
 
-    updateLabelledImage(closestNeighbour, currentRegion);
+    updateNeighborhoodAfterMerge(closestNeighbour, currentRegion);
 
     std::size_t idToRemove = currentRegion->getId();
 
-    delete currentRegion;
+    m_regionPool->destroy(currentRegion);
 
     ++regionsIt; // next region!
 
@@ -723,60 +906,70 @@ std::size_t MultiSeg::mergeSmallRegions()
 
 Region* MultiSeg::getRegion(const std::size_t& id)
 {
-  std::map<std::size_t, Region*>::const_iterator it = m_regions.find(id);
-
-  if(it == m_regions.end())
-    return 0;
-
-  return it->second;
+  return m_regions.get(id);
 }
 
-Region* MultiSeg::getClosestRegion(Region* region, bool useAllNeighbours)
+template<class Merger, bool strict> Region* MultiSeg::getClosestRegion(Region* region, bool useAllNeighbours)
 {
   assert(region);
 
-  // Gets the closest regions
-  std::list<Region*> closestRegions;
-  useAllNeighbours ? closestRegions = region->getNeighbours() : closestRegions = getClosestRegions(region);
+  // Only the closest neighbours searched through the predicates are cached
+  bool useCache = m_cacheClosestRegions && !useAllNeighbours;
 
-  if(closestRegions.empty())
-    return 0;
+  Region* closestRegion = 0;
+  if(useCache && region->getCachedClosestRegion(m_closestEpoch, closestRegion))
+    return closestRegion;
 
-  if(closestRegions.size() == 1)
-    return *closestRegions.begin();
+  // Gets the closest regions
+  std::vector<Region*>& closestRegions = m_closestRegions;
 
-  // There are two or more closest regions. Computes the euclidean distance!
-  Region* closestRegion = 0;
-  double minEuclideanDistance = (std::numeric_limits<double>::max)();
+  if(useAllNeighbours)
+  {
+    closestRegions.assign(region->getNeighbours().begin(), region->getNeighbours().end());
+    m_merger->getSquaredEuclideanDistances(region, closestRegions, m_closestDistances);
+  }
+  else
+    getClosestRegions<Merger, strict>(region, closestRegions, m_closestDistances);
 
-  std::list<Region*>::iterator it;
-  for(it = closestRegions.begin(); it != closestRegions.end(); ++it)
+  if(closestRegions.size() == 1)
   {
-    Region* currentNeighbor = *it;
-    assert(currentNeighbor);
+    closestRegion = closestRegions[0];
+  }
+  else if(closestRegions.size() > 1)
+  {
+    // There are two or more closest regions. Searches the minimum euclidean distance!
+    double minEuclideanDistance = (std::numeric_limits<double>::max)();
 
-    double euclideanDistance = m_merger->getSquaredEuclideanDistance(region, currentNeighbor);
-    
-    if(euclideanDistance < minEuclideanDistance)
+    for(std::size_t i = 0; i < closestRegions.size(); ++i)
     {
-      minEuclideanDistance = euclideanDistance;
-      closestRegion = currentNeighbor;
+      assert(closestRegions[i]);
+
+      if(m_closestDistances[i] < minEuclideanDistance)
+      {
+        minEuclideanDistance = m_closestDistances[i];
+        closestRegion = closestRegions[i];
+      }
     }
   }
 
+  if(useCache)
+    region->setCachedClosestRegion(m_closestEpoch, closestRegion);
+
   return closestRegion;
 }
 
-std::list<Region*> MultiSeg::getClosestRegions(Region* region)
+template<class Merger, bool strict> void MultiSeg::getClosestRegions(Region* region, std::vector<Region*>& closestRegions, std::vector<double>& distances)
 {
+  const Merger* merger = static_cast<const Merger*>(m_merger);
+
   assert(region);
 
-  std::list<Region*>& neighbours = region->getNeighbours();
+  const Neighbourhood& neighbours = region->getNeighbours();
 
-  std::list<Region*>::iterator neighborIt = neighbours.begin();
-  std::list<Region*>::iterator neighborItEnd = neighbours.end();
+  Neighbourhood::const_iterator neighborIt = neighbours.begin();
+  Neighbourhood::const_iterator neighborItEnd = neighbours.end();
 
-  std::list<Region*> closestRegions;
+  closestRegions.clear();
 
   while(neighborIt != neighborItEnd)
   {
@@ -789,19 +982,42 @@ std::list<Region*> MultiSeg::getClosestRegions(Region* region)
       continue;
     }
 
-    if(m_merger->predicate(region, currentNeighbor) == true)
-      closestRegions.push_back(currentNeighbor);
+    closestRegions.push_back(currentNeighbor);
 
     ++neighborIt;
   }
 
-  return closestRegions;
+  // Evaluates the predicates and the distances of all candidates at once
+  std::size_t nPasses = AbstractMerger::evaluatePredicates<Merger, strict>(merger, region, closestRegions, m_closestPasses, distances);
+
+  // Keeps the homogeneous candidates, in the same order
+  std::size_t n = 0;
+  for(std::size_t i = 0; i < closestRegions.size() && n < nPasses; ++i)
+  {
+    if(!m_closestPasses[i])
+      continue;
+
+    closestRegions[n] = closestRegions[i];
+    distances[n] = distances[i];
+    ++n;
+  }
+
+  closestRegions.resize(n);
+  distances.resize(n);
 }
 
 void MultiSeg::updateNeighborhoodAfterMerge(Region* region, Region* merged)
 {
-  std::list<Region*>::iterator neighborIt = merged->getNeighbours().begin();
-  std::list<Region*>::iterator neighborItEnd = merged->getNeighbours().end();
+  // The pixel pairs across the border of the merged region are now inside the grown region, and its other boundaries are boundaries of the grown region
+  if(m_trackCooccurrences)
+  {
+    std::size_t nPairs = m_boundaries.merge(merged->getId(), region->getId(), m_pairSquares);
+    if(nPairs != 0)
+      region->addPixelPairs(nPairs, &m_pairSquares[0]);
+  }
+
+  Neighbourhood::const_iterator neighborIt = merged->getNeighbours().begin();
+  Neighbourhood::const_iterator neighborItEnd = merged->getNeighbours().end();
 
   while(neighborIt != neighborItEnd)
   {
@@ -816,132 +1032,435 @@ void MultiSeg::updateNeighborhoodAfterMerge(Region* region, Region* merged)
   }
 
   region->removeNeighbour(merged);
+
+  // The closest neighbours of the grown region and of its neighbours (including the merged region ones) may have changed
+  region->invalidateCachedClosestRegion();
+
+  neighborIt = region->getNeighbours().begin();
+  neighborItEnd = region->getNeighbours().end();
+
+  while(neighborIt != neighborItEnd)
+  {
+    (*neighborIt)->invalidateCachedClosestRegion();
+    ++neighborIt;
+  }
 }
 
-void MultiSeg::updateRegionStatistics(const TePDITypes::TePDIRasterPtrType& image)
+void MultiSeg::addBoundaryPair(const PixelBuffer& image,
+                               const std::size_t& lin1, const std::size_t& col1, const std::size_t& id1,
+                               const std::size_t& lin2, const std::size_t& col2, const std::size_t& id2)
 {
-  assert(image->params().nlines_ == m_labelledImage->params().nlines_);
-  assert(image->params().ncols_  == m_labelledImage->params().ncols_);
+  const std::size_t nBands = m_bands.size();
 
-  int nBands = m_bands.size();
+  const PixelBuffer::Value* pixel1 = image.getPixel(lin1, col1);
+  const PixelBuffer::Value* pixel2 = image.getPixel(lin2, col2);
 
-  // Statistics to be updated
-  std::vector<double> mean;
-  mean.resize(nBands, 0.0);
+  m_pairSquares.resize(nBands);
 
-  std::vector<double> variance;
-  variance.resize(nBands, 0.0);
+  for(std::size_t b = 0; b < nBands; ++b)
+  {
+    const double difference = static_cast<double>(pixel1[b]) - pixel2[b];
+    m_pairSquares[b] = difference * difference;
+  }
 
-  std::vector<double> cv;
-  cv.resize(nBands, 0.0);
+  m_boundaries.add(id1, id2, 1, &m_pairSquares[0]);
+}
 
-  // To gets the pixel values
-  std::vector<double> pixel;
-  pixel.resize(nBands, 0.0);
+void MultiSeg::updateRegionStatistics(const PixelBuffer& image)
+{
+  assert(image.getNLines() == m_labels.getNLines());
+  assert(image.getNCols()  == m_labels.getNCols());
 
-  double idValue = 0.0;
-  double pixelValue = 0.0;
-  bool valueWasRead;
+  // Applies the deferred relabellings
+  m_labels.resolve();
 
-  std::map<std::size_t, Region*>::iterator regionsIt = m_regions.begin();
-  std::map<std::size_t, Region*>::iterator regionsItEnd = m_regions.end();
+  if(m_regions.empty())
+    return;
 
-  std::size_t nRegions = 0;
-  TePDIPIManager progress("Updating Regions Statistics - Level " + Te2String(m_currentLevel), m_regions.size(), progress_enabled_);
+  const std::size_t nBands = m_bands.size();
+  const std::size_t nLines = m_labels.getNLines();
 
-  while(regionsIt != regionsItEnd) // for each region
+  // The accumulators are indexed by the position of the region on the live regions. i.e. they hold m_regions.size() regions
+  const std::size_t nRegions = m_regions.size();
+
+  m_accumulatorIndices.assign(m_regions.back()->getId() + 1, std::string::npos);
+
+  // The live regions, in the order of the accumulators
+  std::vector<Region*> regions;
+  regions.reserve(nRegions);
+
+  RegionTable::iterator regionsIt;
+  for(regionsIt = m_regions.begin(); regionsIt != m_regions.end(); ++regionsIt)
   {
-    Region* currentRegion = regionsIt->second;
+    m_accumulatorIndices[(*regionsIt)->getId()] = regions.size();
+    regions.push_back(*regionsIt);
+  }
 
-    for(int b = 0; b < nBands; ++b)
+  // One strip of lines for each thread
+  const std::size_t nStrips = (std::max)(static_cast<std::size_t>(1), (std::min)(getNumberOfThreads(), nLines));
+
+  m_accumulators.resize(nStrips);
+
+  TePDIPIManager progress("Updating Regions Statistics - Level " + Te2String(m_currentLevel), nLines, progress_enabled_);
+
+  if(nStrips == 1)
+  {
+    m_accumulators[0].reset(nRegions, nBands, m_trackHigherMoments, m_trackCooccurrences);
+    accumulateRegionStatistics(image, 0, nLines, m_accumulators[0], &progress);
+  }
+  else
+  {
+    // A single image sweep: each thread accumulates the pixels and the pixel runs of its strip
+#ifdef _OPENMP
+    #pragma omp parallel for num_threads(static_cast<int>(nStrips)) schedule(static, 1)
+#endif
+    for(int s = 0; s < static_cast<int>(nStrips); ++s)
     {
-      mean[b] = 0.0;
-      variance[b] = 0.0;
+      m_accumulators[s].reset(nRegions, nBands, m_trackHigherMoments, m_trackCooccurrences);
+      accumulateRegionStatistics(image, (nLines * s) / nStrips, (nLines * (s + 1)) / nStrips, m_accumulators[s], 0);
     }
+  }
+
+  const StatisticsAccumulator& first = m_accumulators[0];
+
+  // The boundaries of the regions, combined in the strip order
+  if(m_trackCooccurrences)
+  {
+    m_boundaries.reset(nBands);
 
-    // Region pixel values (samples)
-    std::vector<std::vector<double> > regionPixels;
+    for(std::size_t s = 0; s < nStrips; ++s)
+      m_accumulators[s].m_boundaries.addTo(m_boundaries);
+  }
+
+  for(std::size_t i = 0; i < nRegions; ++i) // for each region
+  {
+    Region* currentRegion = regions[i];
 
     // Region size
     std::size_t regionSize = 0;
+    for(std::size_t s = 0; s < nStrips; ++s)
+      regionSize += m_accumulators[s].m_counts[i];
 
-    // Analysing in the region boundaries to compute the new statistics values
-    for(std::size_t lin = currentRegion->getYStart(); lin < currentRegion->getYBound(); ++lin)
+    if(regionSize == 0)
     {
-      for(std::size_t col = currentRegion->getXStart(); col < currentRegion->getXBound(); ++col)
-      {
-        valueWasRead = m_labelledImage->getElement(col, lin, idValue);
-        assert(valueWasRead);
+      removeRegion(currentRegion, true);
+      regions[i] = 0;
+      continue;
+    }
+
+    Region::Statistic* mean = currentRegion->getMean();
+    Region::Statistic* variance = currentRegion->getVariance();
+    Region::Statistic* cv = currentRegion->getCV();
+
+    const std::size_t offset = i * nBands;
 
-        // Assert that the read value is a valid region id
-        assert(m_regions.find(static_cast<std::size_t>(idValue)) != m_regions.end());
+    for(std::size_t b = 0; b < nBands; ++b)
+    {
+      // Compute mean
+      double sum = first.m_sums[offset + b];
+      for(std::size_t s = 1; s < nStrips; ++s)
+        sum += m_accumulators[s].m_sums[offset + b];
+
+      const double regionMean = sum / static_cast<double>(regionSize);
+
+      // Compute variance: the squared deviations of each strip around its own mean, plus the deviations of the strip means
+      double squares = 0.0;
+      for(std::size_t s = 0; s < nStrips; ++s)
+      {
+        const StatisticsAccumulator& accumulator = m_accumulators[s];
 
-        // The current pixel composes the region?
-        if(idValue != currentRegion->getId())
+        const double count = static_cast<double>(accumulator.m_counts[i]);
+        if(count == 0.0)
           continue;
 
-        for(int b = 0; b < nBands; ++b)
+        const double shifted = accumulator.m_sums[offset + b] - count * accumulator.m_shifts[offset + b];
+        const double stripMean = accumulator.m_sums[offset + b] / count;
+
+        squares += accumulator.m_squares[offset + b] - (shifted * shifted) / count;
+        squares += count * (stripMean - regionMean) * (stripMean - regionMean);
+      }
+
+      const double regionVariance = (std::max)(0.0, squares / static_cast<double>(regionSize));
+
+      // Stores the statistics. Note: they are computed in double precision, whatever the storage type
+      mean[b] = static_cast<Region::Statistic>(regionMean);
+      variance[b] = static_cast<Region::Statistic>(regionVariance);
+
+      if(regionMean != 0.0)
+        cv[b] = static_cast<Region::Statistic>(sqrt(regionVariance) / regionMean);
+      else
+        cv[b] = 0.0;
+
+      if(m_trackHigherMoments)
+      {
+        // Compute third and fourth central moments: the central moments of each strip, combined in the strip order (Pebay)
+        double n = 0.0;
+        double runningMean = 0.0;
+        double m2 = 0.0;
+        double m3 = 0.0;
+        double m4 = 0.0;
+
+        for(std::size_t s = 0; s < nStrips; ++s)
         {
-          valueWasRead = image->getElement(col, lin, pixelValue, m_bands[b]);
-          assert(valueWasRead);
+          const StatisticsAccumulator& accumulator = m_accumulators[s];
+
+          const double count = static_cast<double>(accumulator.m_counts[i]);
+          if(count == 0.0)
+            continue;
 
-          mean[b] += pixelValue;
+          const double stripMean = accumulator.m_sums[offset + b] / count;
 
-          pixel[b] = pixelValue;
+          // From the sums of the powers of the differences to the shift
+          const double e = stripMean - accumulator.m_shifts[offset + b];
+          const double s2 = accumulator.m_squares[offset + b];
+          const double s3 = accumulator.m_cubes[offset + b];
+          const double s4 = accumulator.m_quartics[offset + b];
+
+          const double stripM2 = s2 - count * e * e;
+          const double stripM3 = s3 - 3.0 * e * s2 + 2.0 * count * e * e * e;
+          const double stripM4 = s4 - 4.0 * e * s3 + 6.0 * e * e * s2 - 3.0 * count * e * e * e * e;
+
+          Utils::CombineCentralMoments(n, count, stripMean - runningMean, m2, m3, m4, stripM2, stripM3, stripM4);
+
+          runningMean += (stripMean - runningMean) * count / (n + count);
+          n += count;
         }
-        
-        ++regionSize;
 
-        if(regionPixels.size() <= m_nSamples)
-          regionPixels.push_back(pixel);
+        currentRegion->getThirdMoment()[b] = static_cast<Region::Statistic>(m3 / static_cast<double>(regionSize));
+        currentRegion->getFourthMoment()[b] = static_cast<Region::Statistic>((std::max)(0.0, m4) / static_cast<double>(regionSize));
       }
     }
 
-    if(regionSize == 0)
+    if(m_trackCooccurrences)
     {
-      ++regionsIt; // next region!
-      removeRegion(currentRegion, true);
-      continue;
-    }
+      // Compute contrast: the mean squared difference of the pixel pairs inside the region
+      std::size_t nPairs = 0;
+      for(std::size_t s = 0; s < nStrips; ++s)
+        nPairs += m_accumulators[s].m_nPairs[i];
 
-    // Compute mean
-    for(int b = 0; b < nBands; ++b)
-      mean[b] /= static_cast<double>(regionSize);
+      Region::Statistic* contrast = currentRegion->getContrast();
+
+      for(std::size_t b = 0; b < nBands; ++b)
+      {
+        double squares = first.m_pairSquares[offset + b];
+        for(std::size_t s = 1; s < nStrips; ++s)
+          squares += m_accumulators[s].m_pairSquares[offset + b];
+
+        contrast[b] = nPairs != 0 ? static_cast<Region::Statistic>(squares / static_cast<double>(nPairs)) : 0.0;
+      }
+
+      currentRegion->setNPairs(nPairs);
+    }
 
-    currentRegion->setMean(mean);
     currentRegion->setSize(regionSize);
+  }
 
-    // Compute variance (from samples)
-    for(std::size_t i = 0; i < regionPixels.size(); ++i) // for each pixel of region
+  // The exact pixel runs of the regions, collected by the sweep. The regions without pixels were removed and have no runs
+  if(m_trackPixelRuns)
+  {
+    m_pixelRuns.clear();
+
+    for(std::size_t i = 0; i < nRegions; ++i)
     {
-      const std::vector<double>& currentPixel = regionPixels[i];
-      for(int b = 0; b < nBands; ++b)
-        variance[b] += ((currentPixel[b] - mean[b]) * (currentPixel[b] - mean[b]));
+      if(regions[i] != 0)
+        regions[i]->setPixelRuns(m_pixelRuns);
     }
 
-    for(int b = 0; b < nBands; ++b)
+    for(std::size_t s = 0; s < nStrips; ++s)
     {
-      variance[b] /= static_cast<double>(regionPixels.size());
+      const std::vector<std::pair<std::size_t, PixelRun> >& runs = m_accumulators[s].m_runs;
 
-      if(mean[b] != 0.0)
-        cv[b] = sqrt(variance[b]) / mean[b];
-      else
-        cv[b] = 0.0;
+      for(std::size_t r = 0; r < runs.size(); ++r)
+        regions[runs[r].first]->appendPixelRun(runs[r].second);
+    }
+  }
+}
+
+void MultiSeg::accumulateRegionStatistics(const PixelBuffer& image,
+                                          const std::size_t& linStart, const std::size_t& linBound,
+                                          StatisticsAccumulator& accumulator, TePDIPIManager* progress)
+{
+  const std::size_t nBands = m_bands.size();
+  const std::size_t nLines = m_labels.getNLines();
+  const std::size_t nCols = m_labels.getNCols();
+  const std::size_t nIds = m_accumulatorIndices.size();
+
+  // To gets the pixel values
+  std::vector<double> pixel(nBands, 0.0);
+
+  for(std::size_t lin = linStart; lin < linBound; ++lin)
+  {
+    const LabelBuffer::Label* labels = m_labels.getLine(lin);
+    const PixelBuffer::Value* line = image.getLine(lin);
+
+    // Run by run: the pixels of a run belong to the same region
+    std::size_t col = 0;
+    while(col < nCols)
+    {
+      const std::size_t colStart = col;
+      const LabelBuffer::Label label = labels[col];
+
+      while(col < nCols && labels[col] == label)
+        ++col;
+
+      // Pixels that do not compose any region. e.g. invalidated pixels
+      const std::size_t index = label < nIds ? m_accumulatorIndices[label] : std::string::npos;
+      if(index == std::string::npos)
+        continue;
+
+      for(std::size_t c = colStart; c < col; ++c)
+      {
+        for(std::size_t b = 0; b < nBands; ++b)
+          pixel[b] = line[c * nBands + b];
+
+        accumulator.add(index, &pixel[0]);
+      }
+
+      if(m_trackPixelRuns)
+      {
+        PixelRun run;
+        run.m_lin = lin;
+        run.m_colStart = colStart;
+        run.m_colBound = col;
+
+        accumulator.m_runs.push_back(std::make_pair(index, run));
+      }
     }
 
-    currentRegion->setVariance(variance);
-    currentRegion->setCV(cv);
+    // The pixel pairs of each pixel with its right and down neighbours. Note: the down pairs of the last strip line read the next strip
+    if(m_trackCooccurrences)
+    {
+      const bool hasNextLine = lin + 1 < nLines;
+
+      const LabelBuffer::Label* nextLabels = hasNextLine ? m_labels.getLine(lin + 1) : 0;
+      const PixelBuffer::Value* nextLine = hasNextLine ? image.getLine(lin + 1) : 0;
 
-    ++regionsIt; // next region!
+      for(std::size_t c = 0; c < nCols; ++c)
+      {
+        const LabelBuffer::Label label = labels[c];
 
-    progress.Update(++nRegions);
+        const std::size_t index = label < nIds ? m_accumulatorIndices[label] : std::string::npos;
+        if(index == std::string::npos)
+          continue;
+
+        if(c + 1 < nCols)
+        {
+          const LabelBuffer::Label right = labels[c + 1];
+          const std::size_t rightIndex = right < nIds ? m_accumulatorIndices[right] : std::string::npos;
+
+          if(rightIndex != std::string::npos)
+            accumulator.addPair(index, label, line + c * nBands, rightIndex, right, line + (c + 1) * nBands);
+        }
+
+        if(hasNextLine)
+        {
+          const LabelBuffer::Label down = nextLabels[c];
+          const std::size_t downIndex = down < nIds ? m_accumulatorIndices[down] : std::string::npos;
+
+          if(downIndex != std::string::npos)
+            accumulator.addPair(index, label, line + c * nBands, downIndex, down, nextLine + c * nBands);
+        }
+      }
+    }
+
+    if(progress)
+      progress->Update(lin + 1);
   }
 }
 
-void MultiSeg::adjustRegionBorders(const TePDITypes::TePDIRasterPtrType& image)
+void MultiSeg::StatisticsAccumulator::reset(const std::size_t& nRegions, const std::size_t& nBands, bool higherMoments, bool pixelPairs)
+{
+  m_nBands = nBands;
+
+  m_counts.assign(nRegions, 0);
+  m_sums.assign(nRegions * nBands, 0.0);
+  m_shifts.assign(nRegions * nBands, 0.0);
+  m_squares.assign(nRegions * nBands, 0.0);
+  m_cubes.assign(higherMoments ? nRegions * nBands : 0, 0.0);
+  m_quartics.assign(higherMoments ? nRegions * nBands : 0, 0.0);
+  m_nPairs.assign(pixelPairs ? nRegions : 0, 0);
+  m_pairSquares.assign(pixelPairs ? nRegions * nBands : 0, 0.0);
+  m_boundaries.reset(nBands);
+  m_runs.clear();
+}
+
+void MultiSeg::StatisticsAccumulator::add(const std::size_t& index, const double* pixel)
 {
-  std::map<std::size_t, Region*>::iterator regionsIt = m_regions.begin();
-  std::map<std::size_t, Region*>::iterator regionsItEnd = m_regions.end();
+  assert(index < m_counts.size());
+
+  const std::size_t offset = index * m_nBands;
+
+  // The first pixel of the region is the shift of its squared deviations
+  if(m_counts[index] == 0)
+  {
+    for(std::size_t b = 0; b < m_nBands; ++b)
+      m_shifts[offset + b] = pixel[b];
+  }
+
+  for(std::size_t b = 0; b < m_nBands; ++b)
+  {
+    const double deviation = pixel[b] - m_shifts[offset + b];
+
+    m_sums[offset + b] += pixel[b];
+    m_squares[offset + b] += deviation * deviation;
+  }
+
+  if(!m_cubes.empty())
+  {
+    for(std::size_t b = 0; b < m_nBands; ++b)
+    {
+      const double deviation = pixel[b] - m_shifts[offset + b];
+      const double square = deviation * deviation;
+
+      m_cubes[offset + b] += square * deviation;
+      m_quartics[offset + b] += square * square;
+    }
+  }
+
+  ++m_counts[index];
+}
+
+void MultiSeg::StatisticsAccumulator::addPair(const std::size_t& index1, const std::size_t& id1, const PixelBuffer::Value* pixel1,
+                                              const std::size_t& index2, const std::size_t& id2, const PixelBuffer::Value* pixel2)
+{
+  assert(index1 < m_nPairs.size());
+  assert(index2 < m_nPairs.size());
+
+  // A pair inside a region
+  if(index1 == index2)
+  {
+    const std::size_t offset = index1 * m_nBands;
+
+    for(std::size_t b = 0; b < m_nBands; ++b)
+    {
+      const double difference = static_cast<double>(pixel1[b]) - pixel2[b];
+      m_pairSquares[offset + b] += difference * difference;
+    }
+
+    ++m_nPairs[index1];
+
+    return;
+  }
+
+  // A pair across the boundary of two regions
+  m_pairBuffer.resize(m_nBands);
+
+  for(std::size_t b = 0; b < m_nBands; ++b)
+  {
+    const double difference = static_cast<double>(pixel1[b]) - pixel2[b];
+    m_pairBuffer[b] = difference * difference;
+  }
+
+  m_boundaries.add(id1, id2, 1, &m_pairBuffer[0]);
+}
+
+template<class Merger> void MultiSeg::adjustRegionBorders(const PixelBuffer& image)
+{
+  // Applies the deferred relabellings
+  m_labels.resolve();
+
+  RegionTable::iterator regionsIt = m_regions.begin();
+  RegionTable::iterator regionsItEnd = m_regions.end();
 
   Pixels alreadyAdjustedPixels;
 
@@ -950,47 +1469,41 @@ void MultiSeg::adjustRegionBorders(const TePDITypes::TePDIRasterPtrType& image)
 
   while(regionsIt != regionsItEnd) // for each region
   {
-    adjustRegionBorders(regionsIt->second, image, alreadyAdjustedPixels);
+    adjustRegionBorders<Merger>(*regionsIt, image, alreadyAdjustedPixels);
     ++regionsIt;
 
     progress.Update(++nRegions);
   }
 }
 
-void MultiSeg::adjustRegionBorders(Region* region,
-                                   const TePDITypes::TePDIRasterPtrType& image,
-                                   Pixels& alreadyAdjustedPixels)
+template<class Merger> void MultiSeg::adjustRegionBorders(Region* region,
+                                                          const PixelBuffer& image,
+                                                          Pixels& alreadyAdjustedPixels)
 {
   assert(region);
 
-  const std::size_t startLine = region->getYStart();
-  const std::size_t startCol = region->getXStart();
-  const std::size_t nLines = region->getYBound();
-  const std::size_t nCols = region->getXBound();
+  const std::size_t lastLine = m_labels.getNLines() - 1;
+  const std::size_t lastCol  = m_labels.getNCols() - 1;
 
-  const std::size_t lastLine = m_labelledImage->params().nlines_ - 1;
-  const std::size_t lastCol  = m_labelledImage->params().ncols_ - 1;
+  // Analysing the region pixels to adjust the borders. Note: the pixels acquired here are already adjusted
+  region->getPixelRuns(m_pixelRuns);
 
-  double idValue = 0.0;
-  bool valueWasRead;
-
-  // Analysing in the region boundaries to adjust the borders
-  for(std::size_t lin = startLine; lin < nLines; ++lin)
+  for(std::size_t r = 0; r < m_pixelRuns.size(); ++r)
   {
-    for(std::size_t col = startCol; col < nCols; ++col)
+    const std::size_t lin = m_pixelRuns[r].m_lin;
+    const LabelBuffer::Label* labels = m_labels.getLine(lin);
+
+    for(std::size_t col = m_pixelRuns[r].m_colStart; col < m_pixelRuns[r].m_colBound; ++col)
     {
-      // The current pixel was already adjusted?
-      if(alreadyAdjustedPixels.find(std::make_pair(lin, col)) != alreadyAdjustedPixels.end())
+      // The current pixel composes the region?
+      if(labels[col] != region->getId())
         continue;
 
-      valueWasRead = m_labelledImage->getElement(col, lin, idValue);
-      assert(valueWasRead);
-
       // Assert that the read value is a valid region id
-      assert(m_regions.find(static_cast<std::size_t>(idValue)) != m_regions.end());
+      assert(m_regions.get(labels[col]) != 0);
 
-      // The current pixel composes the region?
-      if(idValue != region->getId())
+      // The current pixel was already adjusted?
+      if(alreadyAdjustedPixels.find(std::make_pair(lin, col)) != alreadyAdjustedPixels.end())
         continue;
 
       /* Verifying if the current pixel is a border pixel */
@@ -1023,7 +1536,7 @@ void MultiSeg::adjustRegionBorders(Region* region,
       }
 
       // The current pixel is a border pixel. Is necessary an adjustment?
-      std::size_t destiny = computeBorderDestiny(lin, col, region,
+      std::size_t destiny = computeBorderDestiny<Merger>(lin, col, region,
                                                  neighbourLin, neighbourCol, neighbourRegion,
                                                  image);
 
@@ -1041,7 +1554,10 @@ void MultiSeg::adjustRegionBorders(Region* region,
       assert(destiny == region->getId());
 
       // Adjusted!
-      m_labelledImage->setElement(neighbourCol, neighbourLin, destiny);
+      m_labels.set(neighbourLin, neighbourCol, destiny);
+
+      if(m_trackPixelRuns)
+        region->addPixel(neighbourLin, neighbourCol);
 
       // Border already adjusted!
       alreadyAdjustedPixels.insert(std::make_pair(lin, col));
@@ -1078,23 +1594,21 @@ bool MultiSeg::isBorderPixel(const std::size_t& lin, const std::size_t& col, con
                              BorderPixelType& neighbourPixelType,
                              const std::size_t& lastLin, const std::size_t& lastCol)
 {
-  double nid = 0.0;
-  bool valueWasRead;
+  std::size_t nid;
 
   // Try get the value of (Left) pixel
   if(col)
   {
-    valueWasRead = m_labelledImage->getElement(col - 1, lin, nid);
-    assert(valueWasRead);
+    nid = m_labels.get(lin, col - 1);
 
     // Assert that the read value is a valid region id
-    assert(m_regions.find(static_cast<std::size_t>(nid)) != m_regions.end());
+    assert(m_regions.get(nid) != 0);
 
-    if(static_cast<std::size_t>(nid) != regionId)
+    if(nid != regionId)
     {
       neighbourLin = lin;
       neighbourCol = col - 1;
-      neighbourRegionId = static_cast<std::size_t>(nid);
+      neighbourRegionId = nid;
       neighbourPixelType = Left;
       return true;
     }
@@ -1103,17 +1617,16 @@ bool MultiSeg::isBorderPixel(const std::size_t& lin, const std::size_t& col, con
   // Try get the value of (Right) pixel
   if(col < lastCol)
   {
-    valueWasRead = m_labelledImage->getElement(col + 1, lin, nid);
-    assert(valueWasRead);
+    nid = m_labels.get(lin, col + 1);
 
     // Assert that the read value is a valid region id
-    assert(m_regions.find(static_cast<std::size_t>(nid)) != m_regions.end());
+    assert(m_regions.get(nid) != 0);
 
-    if(static_cast<std::size_t>(nid) != regionId)
+    if(nid != regionId)
     {
       neighbourLin = lin;
       neighbourCol = col + 1;
-      neighbourRegionId = static_cast<std::size_t>(nid);
+      neighbourRegionId = nid;
       neighbourPixelType = Right;
       return true;
     }
@@ -1122,17 +1635,16 @@ bool MultiSeg::isBorderPixel(const std::size_t& lin, const std::size_t& col, con
   // Try gets the value of (Top) pixel
   if(lin)
   {
-    valueWasRead = m_labelledImage->getElement(col, lin - 1, nid);
-    assert(valueWasRead);
+    nid = m_labels.get(lin - 1, col);
 
     // Assert that the read value is a valid region id
-    assert(m_regions.find(static_cast<std::size_t>(nid)) != m_regions.end());
+    assert(m_regions.get(nid) != 0);
 
-    if(static_cast<std::size_t>(nid) != regionId)
+    if(nid != regionId)
     {
       neighbourLin = lin - 1;
       neighbourCol = col;
-      neighbourRegionId = static_cast<std::size_t>(nid);
+      neighbourRegionId = nid;
       neighbourPixelType = Top;
       return true;
     }
@@ -1141,17 +1653,16 @@ bool MultiSeg::isBorderPixel(const std::size_t& lin, const std::size_t& col, con
   // Try gets the value of (Bottom) pixel
   if(lin < lastLin)
   {
-    valueWasRead = m_labelledImage->getElement(col, lin + 1, nid);
-    assert(valueWasRead);
+    nid = m_labels.get(lin + 1, col);
 
     // Assert that the read value is a valid region id
-    assert(m_regions.find(static_cast<std::size_t>(nid)) != m_regions.end());
+    assert(m_regions.get(nid) != 0);
 
-    if(static_cast<std::size_t>(nid) != regionId)
+    if(nid != regionId)
     {
       neighbourLin = lin + 1;
       neighbourCol = col;
-      neighbourRegionId = static_cast<std::size_t>(nid);
+      neighbourRegionId = nid;
       neighbourPixelType = Bottom;
       return true;
     }
@@ -1160,10 +1671,12 @@ bool MultiSeg::isBorderPixel(const std::size_t& lin, const std::size_t& col, con
   return false; // no border pixel!
 }
 
-std::size_t MultiSeg::computeBorderDestiny(const std::size_t& linA, const std::size_t& colA, Region* rA,
-                                           const std::size_t& linB, const std::size_t& colB, Region* rB,
-                                           const TePDITypes::TePDIRasterPtrType& image)
+template<class Merger> std::size_t MultiSeg::computeBorderDestiny(const std::size_t& linA, const std::size_t& colA, Region* rA,
+                                                                  const std::size_t& linB, const std::size_t& colB, Region* rB,
+                                                                  const PixelBuffer& image)
 {
+  const Merger* merger = static_cast<const Merger*>(m_merger);
+
   assert(rA);
   assert(rB);
 
@@ -1177,11 +1690,11 @@ std::size_t MultiSeg::computeBorderDestiny(const std::size_t& linA, const std::s
   getPixelValues(linA, colA, pixelAValues, image);
   getPixelValues(linB, colB, pixelBValues, image);
 
-  double VAa = m_merger->getDissimilarity(pixelAValues, rA);
-  double VBa = m_merger->getDissimilarity(pixelAValues, rB);
+  double VAa = AbstractMerger::evaluateDissimilarity(merger, pixelAValues, rA);
+  double VBa = AbstractMerger::evaluateDissimilarity(merger, pixelAValues, rB);
 
-  double VBb = m_merger->getDissimilarity(pixelBValues, rB);
-  double VAb = m_merger->getDissimilarity(pixelBValues, rA);
+  double VBb = AbstractMerger::evaluateDissimilarity(merger, pixelBValues, rB);
+  double VAb = AbstractMerger::evaluateDissimilarity(merger, pixelBValues, rA);
 
   if(VAa < VBa && VBb >= VAb)
     return rA->getId();
@@ -1192,13 +1705,18 @@ std::size_t MultiSeg::computeBorderDestiny(const std::size_t& linA, const std::s
   return std::string::npos;
 }
 
-void MultiSeg::splitRegions(const TePDITypes::TePDIRasterPtrType& image, std::map<std::size_t, Region*>& newRegions)
+template<class Merger, bool strict> void MultiSeg::splitRegions(const PixelBuffer& image, RegionTable& newRegions)
 {
-  // The current regions
-  std::map<std::size_t, Region*> currentRegions = m_regions;
+  const Merger* merger = static_cast<const Merger*>(m_merger);
+
+  // Applies the deferred relabellings
+  m_labels.resolve();
 
-  std::map<std::size_t, Region*>::iterator regionsIt = currentRegions.begin();
-  std::map<std::size_t, Region*>::iterator regionsItEnd = currentRegions.end();
+  // The current regions. Note: the split regions are replaced by new regions on m_regions
+  std::vector<Region*> currentRegions(m_regions.begin(), m_regions.end());
+
+  std::vector<Region*>::iterator regionsIt = currentRegions.begin();
+  std::vector<Region*>::iterator regionsItEnd = currentRegions.end();
 
   // Round ENL value to get CV from table
   std::size_t enl = static_cast<std::size_t>(m_currentENL);
@@ -1210,7 +1728,7 @@ void MultiSeg::splitRegions(const TePDITypes::TePDIRasterPtrType& image, std::ma
 
   while(regionsIt != regionsItEnd) // for each region
   {
-    Region* currentRegion = regionsIt->second;
+    Region* currentRegion = *regionsIt;
 
     // In this case, extracts the coefficient of variation from table
     if(m_imageType == Radar && m_imageModel == Cartoon)
@@ -1220,7 +1738,7 @@ void MultiSeg::splitRegions(const TePDITypes::TePDIRasterPtrType& image, std::ma
       m_merger->setParam("cv_threshold", m_currentCV);
     }
 
-    if(m_merger->isHomogenous(currentRegion))
+    if(AbstractMerger::evaluateHomogeneity<Merger, strict>(merger, currentRegion))
     {
       ++numberOfHomogenousRegions;
       ++regionsIt;  // next region!
@@ -1242,35 +1760,31 @@ void MultiSeg::invalidateRegionPixels(Region* region)
 {
   assert(region);
 
-  double idValue = 0.0;
-  bool valueWasRead;
+  region->getPixelRuns(m_pixelRuns);
 
-  for(std::size_t lin = region->getYStart(); lin < region->getYBound(); ++lin)
+  for(std::size_t r = 0; r < m_pixelRuns.size(); ++r)
   {
-    for(std::size_t col = region->getXStart(); col < region->getXBound(); ++col)
-    {
-      valueWasRead = m_labelledImage->getElement(col, lin, idValue);
-      assert(valueWasRead);
+    LabelBuffer::Label* labels = m_labels.getLine(m_pixelRuns[r].m_lin);
 
+    for(std::size_t col = m_pixelRuns[r].m_colStart; col < m_pixelRuns[r].m_colBound; ++col)
+    {
       // The current pixel composes the region?
-      if(idValue != region->getId()) 
+      if(labels[col] != region->getId()) 
         continue;
 
-      m_labelledImage->setElement(col, lin, std::string::npos); // Invalidated!
+      labels[col] = LabelBuffer::sm_invalidLabel; // Invalidated!
     }
   }
 }
 
-void MultiSeg::splitRegion(Region* region, const TePDITypes::TePDIRasterPtrType& image, std::map<std::size_t, Region*>& newRegions)
+void MultiSeg::splitRegion(Region* region, const PixelBuffer& image, RegionTable& newRegions)
 {
   assert(region);
 
   // First, invalidate the region pixels
   invalidateRegionPixels(region);
 
-  double idValue = 0.0;
-  double pixelValue = 0.0;
-  bool valueWasRead;
+  std::size_t idValue;
 
   int nBands = m_bands.size();
 
@@ -1278,101 +1792,107 @@ void MultiSeg::splitRegion(Region* region, const TePDITypes::TePDIRasterPtrType&
   pixel.resize(nBands, 0.0);
 
   // The last region id
-  std::map<std::size_t, Region*>::reverse_iterator it = m_regions.rbegin();
-  assert(it->second);
-  std::size_t lastId = it->second->getId();
+  assert(m_regions.back());
+  std::size_t lastId = m_regions.back()->getId();
 
-  const std::size_t lastLine = m_labelledImage->params().nlines_ - 1;
-  const std::size_t lastCol  = m_labelledImage->params().ncols_ - 1;
+  const std::size_t lastLine = m_labels.getNLines() - 1;
+  const std::size_t lastCol  = m_labels.getNCols() - 1;
 
-  for(std::size_t lin = region->getYStart(); lin < region->getYBound(); ++lin)
+  // Note: the invalidation left the region pixel runs on m_pixelRuns
+  for(std::size_t r = 0; r < m_pixelRuns.size(); ++r)
   {
-    for(std::size_t col = region->getXStart(); col < region->getXBound(); ++col)
-    {
-      valueWasRead = m_labelledImage->getElement(col, lin, idValue);
-      assert(valueWasRead);
+    const std::size_t lin = m_pixelRuns[r].m_lin;
 
+    for(std::size_t col = m_pixelRuns[r].m_colStart; col < m_pixelRuns[r].m_colBound; ++col)
+    {
       // The current pixel composes the region? Remember: the region was invalidated!
-      if(idValue != std::string::npos)
+      if(m_labels.get(lin, col) != LabelBuffer::sm_invalidLabel)
         continue;
 
+      const PixelBuffer::Value* values = image.getPixel(lin, col);
+
       for(int b = 0; b < nBands; ++b)
-      {
-        image->getElement(col, lin, pixelValue, m_bands[b]);
-        pixel[b] = pixelValue;
-      }
+        pixel[b] = values[b];
 
       // Generates an id for the new region
       std::size_t id = ++lastId;
 
       // Initializing the new region
-      Region* newRegion = new Region(id, pixel, lin, col);
+      Region* newRegion = m_regionPool->create(id, pixel, lin, col);
 
       // Indexing...
-      assert(m_regions.find(id) == m_regions.end());
-      m_regions[id] = newRegion;
+      assert(m_regions.get(id) == 0);
+      m_regions.insert(newRegion);
 
       // It is a new region!
-      assert(newRegions.find(id) == newRegions.end());
-      newRegions[id] = newRegion;
+      assert(newRegions.get(id) == 0);
+      newRegions.insert(newRegion);
 
       // Writing the new region body
-      m_labelledImage->setElement(col, lin, id);
+      m_labels.set(lin, col, id);
 
       // Building the neighborhood information
       if(lin)
       {
-        valueWasRead = m_labelledImage->getElement(col, lin - 1, idValue);
-        assert(valueWasRead);
+        idValue = m_labels.get(lin - 1, col);
 
-        if(idValue != std::string::npos)
+        if(idValue != LabelBuffer::sm_invalidLabel)
         {
-          Region* neighbour = getRegion(static_cast<std::size_t>(idValue));
+          Region* neighbour = getRegion(idValue);
           assert(neighbour);
           newRegion->addNeighbour(neighbour);
           neighbour->addNeighbour(newRegion);
+
+          if(m_trackCooccurrences)
+            addBoundaryPair(image, lin, col, id, lin - 1, col, idValue);
         }
       }
 
       if(col)
       {
-        valueWasRead = m_labelledImage->getElement(col - 1, lin, idValue);
-        assert(valueWasRead);
+        idValue = m_labels.get(lin, col - 1);
 
-        if(idValue != std::string::npos)
+        if(idValue != LabelBuffer::sm_invalidLabel)
         {
-          Region* neighbour = getRegion(static_cast<std::size_t>(idValue));
+          Region* neighbour = getRegion(idValue);
           assert(neighbour);
           newRegion->addNeighbour(neighbour);
           neighbour->addNeighbour(newRegion);
+
+          if(m_trackCooccurrences)
+            addBoundaryPair(image, lin, col, id, lin, col - 1, idValue);
         }
       }
 
       if(lin < lastLine)
       {
-        valueWasRead = m_labelledImage->getElement(col, lin + 1, idValue);
-        assert(valueWasRead);
+        idValue = m_labels.get(lin + 1, col);
 
-        if(idValue != std::string::npos)
+        if(idValue != LabelBuffer::sm_invalidLabel)
         {
-          Region* neighbour = getRegion(static_cast<std::size_t>(idValue));
+          Region* neighbour = getRegion(idValue);
           assert(neighbour);
           newRegion->addNeighbour(neighbour);
           neighbour->addNeighbour(newRegion);
+
+          if(m_trackCooccurrences)
+            addBoundaryPair(image, lin, col, id, lin + 1, col, idValue);
         }
       }
 
       if(col < lastCol)
       {
-        valueWasRead = m_labelledImage->getElement(col + 1, lin, idValue);
-        assert(valueWasRead);
+        idValue = m_labels.get(lin, col + 1);
 
-        if(idValue != std::string::npos)
+        if(idValue != LabelBuffer::sm_invalidLabel)
         {
-          Region* neighbour = getRegion(static_cast<std::size_t>(idValue));
+          Region* neighbour = getRegion(idValue);
           assert(neighbour);
           newRegion->addNeighbour(neighbour);
           neighbour->addNeighbour(newRegion);
+
+          if(m_trackCooccurrences)
+            addBoundaryPair(image, lin, col, id, lin, col + 1, idValue);
         }
       }
     }
@@ -1382,7 +1902,7 @@ void MultiSeg::splitRegion(Region* region, const TePDITypes::TePDIRasterPtrType&
   removeRegion(region);
 }
 
-void MultiSeg::processSmallRegions()
+template<class Merger, bool strict> void MultiSeg::processSmallRegions()
 {
   std::size_t mergedRegions;
 
@@ -1390,7 +1910,7 @@ void MultiSeg::processSmallRegions()
   {
     while(true)
     {
-      mergedRegions = mergeSmallRegions();
+      mergedRegions = mergeSmallRegions<Merger, strict>();
       if(mergedRegions == 0)
         break;
     }
@@ -1402,26 +1922,37 @@ void MultiSeg::updateLabelledImage(Region* region, Region* merged)
   std::size_t regionId = region->getId();
   std::size_t mergedId = merged->getId();
 
-  double value = 0.0;
-  bool valueWasRead;
+  if(m_trackPixelRuns)
+    region->absorbPixelRuns(merged);
 
-  for(std::size_t lin = merged->getYStart(); lin < merged->getYBound(); ++lin)
+  if(m_deferLabelUpdates)
   {
-    for(std::size_t col = merged->getXStart(); col < merged->getXBound(); ++col)
-    {
-      valueWasRead = m_labelledImage->getElement(col, lin, value);
-      assert(valueWasRead);
+    m_labels.merge(mergedId, regionId);
+    return;
+  }
+
+  assert(regionId < LabelBuffer::sm_invalidLabel);
+
+  const LabelBuffer::Label label = static_cast<LabelBuffer::Label>(regionId);
+
+  merged->getPixelRuns(m_pixelRuns);
+
+  for(std::size_t r = 0; r < m_pixelRuns.size(); ++r)
+  {
+    LabelBuffer::Label* labels = m_labels.getLine(m_pixelRuns[r].m_lin);
 
-      if(value == mergedId)
-        m_labelledImage->setElement(col, lin, static_cast<double>(regionId));
+    for(std::size_t col = m_pixelRuns[r].m_colStart; col < m_pixelRuns[r].m_colBound; ++col)
+    {
+      if(labels[col] == mergedId)
+        labels[col] = label;
     }
   }
 }
 
 void MultiSeg::removeRegion(Region* region, bool linkNeighbourhood)
 {
-  std::list<Region*>::iterator neighborIt = region->getNeighbours().begin();
-  std::list<Region*>::iterator neighborItEnd = region->getNeighbours().end();
+  Neighbourhood::const_iterator neighborIt = region->getNeighbours().begin();
+  Neighbourhood::const_iterator neighborItEnd = region->getNeighbours().end();
 
   while(neighborIt != neighborItEnd) // for each neighbor
   {
@@ -1429,8 +1960,8 @@ void MultiSeg::removeRegion(Region* region, bool linkNeighbourhood)
 
     if(linkNeighbourhood || (*neighborIt)->getNeighbours().empty())
     {
-      std::list<Region*>::iterator nnIt = region->getNeighbours().begin();
-      std::list<Region*>::iterator nnItEnd = region->getNeighbours().end();
+      Neighbourhood::const_iterator nnIt = region->getNeighbours().begin();
+      Neighbourhood::const_iterator nnItEnd = region->getNeighbours().end();
 
       while(nnIt != nnItEnd)
       {
@@ -1447,33 +1978,105 @@ void MultiSeg::removeRegion(Region* region, bool linkNeighbourhood)
     ++neighborIt;
   }
 
+  // The region pixels no longer border any region
+  if(m_trackCooccurrences)
+    m_boundaries.erase(region->getId());
+
   m_regions.erase(region->getId());
 
-  delete region;
+  m_regionPool->destroy(region);
 }
 
 void MultiSeg::getPixelValues(const std::size_t& lin, const std::size_t& col,
                               std::vector<double>& pixel,
-                              const TePDITypes::TePDIRasterPtrType& image)
+                              const PixelBuffer& image)
 {
-  double value = 0.0;
-  bool valueWasRead;
+  const PixelBuffer::Value* values = image.getPixel(lin, col);
 
-  int nBands = m_bands.size();
+  const std::size_t nBands = m_bands.size();
+
+  for(std::size_t b = 0; b < nBands; ++b)
+    pixel[b] = values[b];
+}
+
+void MultiSeg::resizeRegions(const TeRasterParams& params)
+{
+  const std::size_t nLines = params.nlines_;
+  const std::size_t nCols = params.ncols_;
 
-  for(int b = 0; b < nBands; ++b)
+  // The pixel runs of the resized labelled image are the current ones, scaled. So, they are built from the current labels
+  if(m_trackPixelRuns)
+    rebuildPixelRuns(2, nLines, nCols);
+
+  m_labels.upsample(params, getNumberOfThreads());
+
+  RegionTable::iterator it;
+  for(it = m_regions.begin(); it != m_regions.end(); ++it)
+    (*it)->updateBounds(2, nLines, nCols);
+}
+
+void MultiSeg::rebuildPixelRuns(const std::size_t& scale, const std::size_t& nScaledLines, const std::size_t& nScaledCols)
+{
+  m_pixelRuns.clear();
+
+  RegionTable::iterator it;
+  for(it = m_regions.begin(); it != m_regions.end(); ++it)
+    (*it)->setPixelRuns(m_pixelRuns);
+
+  const std::size_t nLines = m_labels.getNLines();
+  const std::size_t nCols = m_labels.getNCols();
+
+  // The scaled runs of a line, with their regions
+  std::vector<std::pair<Region*, PixelRun> > lineRuns;
+
+  for(std::size_t lin = 0; lin < nLines; ++lin)
   {
-    valueWasRead = image->getElement(col, lin, value, m_bands[b]);
-    assert(valueWasRead);
-    pixel[b] = value;
+    const LabelBuffer::Label* labels = m_labels.getLine(lin);
+
+    // The line is scanned once
+    lineRuns.clear();
+
+    std::size_t col = 0;
+    while(col < nCols)
+    {
+      const std::size_t colStart = col;
+
+      while(col < nCols && labels[col] == labels[colStart])
+        ++col;
+
+      Region* region = getRegion(labels[colStart]);
+      if(region == 0)
+        continue;
+
+      PixelRun run;
+      run.m_colStart = colStart * scale;
+      run.m_colBound = (std::min)(col * scale, nScaledCols);
+
+      lineRuns.push_back(std::make_pair(region, run));
+    }
+
+    // Each line covers scale lines of the scaled image. Its runs are emitted for each one, in the order of the lines
+    for(std::size_t scaledLin = lin * scale; scaledLin < (std::min)((lin + 1) * scale, nScaledLines); ++scaledLin)
+    {
+      for(std::size_t r = 0; r < lineRuns.size(); ++r)
+      {
+        lineRuns[r].second.m_lin = scaledLin;
+        lineRuns[r].first->appendPixelRun(lineRuns[r].second);
+      }
+    }
   }
 }
 
-void MultiSeg::resizeRegions()
+std::size_t MultiSeg::getNumberOfThreads() const
 {
-  std::map<std::size_t, Region*>::iterator it;
-  for(it = m_regions.begin(); it != m_regions.end(); ++it)
-    it->second->updateBounds(2, m_labelledImage->params().nlines_, m_labelledImage->params().ncols_);
+#ifdef _OPENMP
+  if(m_nThreads == 0)
+    return static_cast<std::size_t>(omp_get_num_procs());
+
+  return m_nThreads;
+#else
+  return 1;
+#endif
 }
 
 void MultiSeg::updateThresholds(const std::size_t& currentLevel)
@@ -1505,8 +2108,6 @@ void MultiSeg::updateThresholds(const std::size_t& currentLevel)
   // Informs the current merger
   m_merger->setParam("cv_threshold", m_currentCV);
 
-  m_nSamples = m_nSamples * 4;
-
   if(m_imageType == Radar && m_imageModel == Cartoon)
   {
     boost::math::gamma_distribution<double> gamma(m_currentENL, 1.0);
@@ -1520,17 +2121,21 @@ void MultiSeg::updateThresholds(const std::size_t& currentLevel)
 
   if(m_imageType == Optical && m_imageModel == Cartoon)
   {
-    TePDIStatistic* stats = m_pyramid->buildStats(m_currentLevel);
+    // The level statistics were computed while the pyramid was built
     for(std::size_t i = 0; i < m_bands.size(); ++i)
     {
       std::string name = "image_variance_" + Te2String(i);
-      m_merger->setParam(name, stats->getVariance(i)); 
+      m_merger->setParam(name, m_pyramid->getVariance(m_currentLevel, i));
     }
   }
 }
 
 void MultiSeg::notifyResult()
 {
+  // Updates the labelled image that will be outputted
+  m_labels.resolve();
+  m_labelledImage = m_labels.createRaster();
+
   for(std::size_t i = 0; i < m_outputters.size(); ++i)
     m_outputters[i]->output(*this, m_currentLevel);
 }
@@ -26,25 +26,32 @@
 #define __MULTISEG_INTERNAL_MULTISEG_H
 
 // MultiSeg
+#include "BoundaryTable.h"
 #include "Config.h"
 #include "CVTable.h"
 #include "Enums.h"
+#include "LabelBuffer.h"
+#include "PixelBuffer.h"
 #include "Pyramid.h"
+#include "Region.h"
+#include "RegionTable.h"
 
 // TerraLib PDI
 #include <terralib/image_processing/TePDIAlgorithm.hpp>
 
 // STL
-#include <list>
 #include <map>
+#include <queue>
 #include <set>
 #include <string>
 #include <utility>
+#include <vector>
 
 // Forward declaration
 class AbstractMerger;
 class AbstractOutputter;
-class Region;
+class RegionPool;
+class TePDIPIManager;
 
 /*! \brief Set of pixel indexes. */
 typedef std::set<std::pair<std::size_t, std::size_t> > Pixels;
@@ -76,8 +83,13 @@ typedef std::set<std::pair<std::size_t, std::size_t> > Pixels;
   \param similarity (double) - Expressed in dB case ImageType == Radar or gray scale case ImageType == Optical.
   \param min_area (std::size_t) - Region pixel size minimum value.
   \param ENL (double) - Number of looks. Required when ImageType == Radar and ImageModelRepresentation == Cartoon.
-  \param confidence_level (double) - Required when ImageType == Radar and ImageModelRepresentation == Texture. Or ImageType == Optical.
+  \param confidence_level (double) - Required when ImageType == Radar or ImageType == Optical.
   \param cv (double) - Coefficient of variation. Required when ImageType == Radar and ImageModelRepresentation == Texture. Or ImageType == Optical.
+
+  \note The optional parameters:
+
+  \param region_growing_strategy (RegionGrowingStrategy)
+  Defines how the candidate merges are searched during the region growing process (Passes or PriorityQueue). Default: Passes.
 */
 class MSEGEXPORT MultiSeg : public TePDIAlgorithm
 {
@@ -112,12 +124,15 @@ class MSEGEXPORT MultiSeg : public TePDIAlgorithm
 
       \return The set of found regions.
     */
-    const std::map<std::size_t, Region*>& getRegions() const;
+    const RegionTable& getRegions() const;
 
     /*!
       \brief This method returns the labelled image. i.e. the image that contains the regions identifiers.
 
       \return The labelled image.
+
+      \note The labelled image is updated each time the results are notified. i.e. at the end of the segmentation
+            and, if intermediate results were requested, at the end of each level.
     */
     const TePDITypes::TePDIRasterPtrType& getLabelledImage() const;
 
@@ -141,6 +156,61 @@ class MSEGEXPORT MultiSeg : public TePDIAlgorithm
     /*! \brief This method sets if the intermediate results must be notified. */
     void notifyIntermediateResults(bool on);
 
+    /*!
+      \brief This method sets if the relabelling of the merged regions pixels must be deferred.
+
+      \note If on (default), each merge only links the labels on a disjoint set forest and the labelled image is
+            rewritten in one pass when it is required. Otherwise, the bounding box of each merged region is rewritten
+            right after the merge.
+    */
+    void deferLabelUpdates(bool on);
+
+    /*!
+      \brief This method sets if the pixel runs of the regions must be maintained.
+
+      \note If on (default), each region keeps the runs of its pixels across merges, border adjustments, splits
+            and level changes, so the region passes visit only its own pixels. Otherwise, they scan the region bounding box.
+    */
+    void trackPixelRuns(bool on);
+
+    /*!
+      \brief This method sets if the closest neighbour of each region must be cached during the region growing.
+
+      \note If on (default), a region reuses its closest neighbour until a merge changes the region or one of its
+            neighbours, or until the similarity threshold changes. Otherwise, it is searched again on each request.
+    */
+    void cacheClosestRegions(bool on);
+
+    /*!
+      \brief This method sets the number of threads used by the image sweeps. e.g. the pyramid build and the region statistics computation.
+
+      \param nThreads The number of threads. The default value is 1. 0 means the number of available processors.
+
+      \note It is effective only if MultiSeg was built with OpenMP support. The input image must support concurrent
+            reads, since the threads read it into the pyramid base level.
+    */
+    void setNumberOfThreads(const std::size_t& nThreads);
+
+    /*!
+      \brief This method sets the maximum number of bytes of the pyramid levels held in memory.
+
+      \param bytes The memory budget, in bytes. The default value is 0, that means no limit.
+
+      \note The levels that exceed the budget are released and rebuilt when they are needed. The input image is not considered.
+    */
+    void setPyramidMemoryBudget(const std::size_t& bytes);
+
+    /*!
+      \brief This method sets the directory of the pyramid cache files.
+
+      \param directory The directory. The default value is empty, that means no cache.
+
+      \note The pyramid of an image file is written to the cache when it is built. The next segmentations of the same
+            image file, with the same bands and number of levels, map the cached levels instead of building them.
+            e.g. while the segmentation parameters are tuned. See PyramidCache.
+    */
+    void setPyramidCacheDirectory(const std::string& directory);
+
   protected:
 
     /*!
@@ -165,63 +235,96 @@ class MSEGEXPORT MultiSeg : public TePDIAlgorithm
     /*! \brief This method initializes the merger that will be used based on input MultiSeg parameters. */
     void initializeMerger();
 
+    /** @name Segmentation
+      * The passes that evaluate the merger are member templates on the concrete merger type and on its strict mode.
+      * So, the predicates, dissimilarities and homogeneity tests are called without virtual dispatch, and their band
+      * loops are inlined on the passes. The instantiation is dispatched once for each merger, by RunImplementation(). */
+    //@{
+
+    /*! \brief This method dispatches the strict mode of the current merger, that must be a Merger. */
+    template<class Merger> void segment();
+
+    /*! \brief This method segments the pyramid levels, from the lowest one. i.e. all the steps before the minimum area process. */
+    template<class Merger, bool strict> void segment();
+
+    //@}
+
     /** @name Region Growing */
     //@{
 
-    void initializeRegions(const TePDITypes::TePDIRasterPtrType& image);
+    void initializeRegions(const PixelBuffer& image);
 
-    void executeRegionGrowing(std::map<std::size_t, Region*>& regions, bool usingRandomSeeds = false, std::size_t maxIterations = 100);
+    template<class Merger, bool strict> void executeRegionGrowing(RegionTable& regions, bool usingRandomSeeds = false, std::size_t maxIterations = 100);
 
-    std::size_t mergeRegions(std::map<std::size_t, Region*>& regions);
+    template<class Merger, bool strict> std::size_t mergeRegions(RegionTable& regions);
 
-    std::size_t mergeRegionsRandomly(std::map<std::size_t, Region*>& regions);
+    template<class Merger, bool strict> std::size_t mergeRegionsRandomly(RegionTable& regions);
 
-    std::size_t mergeSmallRegions();
+    template<class Merger, bool strict> std::size_t mergeRegionsByPriority(RegionTable& regions);
+
+    template<class Merger, bool strict> void pushMergeCandidate(Region* region, const RegionTable& regions);
+
+    template<class Merger, bool strict> std::size_t mergeSmallRegions();
 
     Region* getRegion(const std::size_t& id);
 
-    Region* getClosestRegion(Region* region, bool useAllNeighbours = false);
+    template<class Merger, bool strict> Region* getClosestRegion(Region* region, bool useAllNeighbours = false);
 
-    std::list<Region*> getClosestRegions(Region* region);
+    template<class Merger, bool strict> void getClosestRegions(Region* region, std::vector<Region*>& closestRegions, std::vector<double>& distances);
 
     void updateNeighborhoodAfterMerge(Region* region, Region* merged);
 
+    /*!
+      \brief This method adds the pixel pair of two neighbour pixels to the boundary of their regions.
+
+      \param image The image of the current level.
+      \param lin1  The line of the first pixel.
+      \param col1  The column of the first pixel.
+      \param id1   The region identifier of the first pixel.
+      \param lin2  The line of the second pixel.
+      \param col2  The column of the second pixel.
+      \param id2   The region identifier of the second pixel.
+    */
+    void addBoundaryPair(const PixelBuffer& image,
+                         const std::size_t& lin1, const std::size_t& col1, const std::size_t& id1,
+                         const std::size_t& lin2, const std::size_t& col2, const std::size_t& id2);
+
     //@}
 
     /** @name Border Adjustments  */
     //@{
 
-    void updateRegionStatistics(const TePDITypes::TePDIRasterPtrType& image);
+    void updateRegionStatistics(const PixelBuffer& image);
 
-    void adjustRegionBorders(const TePDITypes::TePDIRasterPtrType& image);
+    template<class Merger> void adjustRegionBorders(const PixelBuffer& image);
 
-    void adjustRegionBorders(Region* region, const TePDITypes::TePDIRasterPtrType& image, Pixels& alreadyAdjustedPixels);
+    template<class Merger> void adjustRegionBorders(Region* region, const PixelBuffer& image, Pixels& alreadyAdjustedPixels);
 
     bool isBorderPixel(const std::size_t& lin, const std::size_t& col, const std::size_t& regionId,
                        std::size_t& neighbourLin, std::size_t& neighbourCol, std::size_t& neighbourRegionId,
                        BorderPixelType& neighbourPixelType,
                        const std::size_t& lastLin, const std::size_t& lastCol);
 
-    std::size_t computeBorderDestiny(const std::size_t& linA, const std::size_t& colA, Region* rA,
-                                     const std::size_t& linB, const std::size_t& colB, Region* rB,
-                                     const TePDITypes::TePDIRasterPtrType& image);
+    template<class Merger> std::size_t computeBorderDestiny(const std::size_t& linA, const std::size_t& colA, Region* rA,
+                                                            const std::size_t& linB, const std::size_t& colB, Region* rB,
+                                                            const PixelBuffer& image);
     //@}
 
     /** @name Resegmentation */
     //@{
 
-    void splitRegions(const TePDITypes::TePDIRasterPtrType& image, std::map<std::size_t, Region*>& newRegions);
+    template<class Merger, bool strict> void splitRegions(const PixelBuffer& image, RegionTable& newRegions);
 
     void invalidateRegionPixels(Region* region);
 
-    void splitRegion(Region* region, const TePDITypes::TePDIRasterPtrType& image, std::map<std::size_t, Region*>& newRegions);
+    void splitRegion(Region* region, const PixelBuffer& image, RegionTable& newRegions);
 
     //@}
 
     /** @name Minimum Area  */
     //@{
 
-    void processSmallRegions();
+    template<class Merger, bool strict> void processSmallRegions();
 
     //@}
 
@@ -234,9 +337,28 @@ class MSEGEXPORT MultiSeg : public TePDIAlgorithm
 
     void getPixelValues(const std::size_t& lin, const std::size_t& col,
                         std::vector<double>& pixel,
-                        const TePDITypes::TePDIRasterPtrType& image);
+                        const PixelBuffer& image);
+
+    /*!
+      \brief This method upsamples the labelled image by 2 to the given geometry, and scales the regions bounds and pixel runs.
+
+      \param params The raster parameters of the next finer level.
+    */
+    void resizeRegions(const TeRasterParams& params);
+
+    /*!
+      \brief This method rebuilds the pixel runs of all regions from the labelled image, scaled by the given factor.
+
+      Each line of the labelled image is scanned once, and its runs are emitted for each of the scaled lines it covers.
+      So, for the upsampling by 2, it scans a quarter of the pixels of the scaled image.
 
-    void resizeRegions();
+      \param scale        The scale factor. e.g. 1 for the labelled image itself, or 2 for its upsampled version.
+      \param nScaledLines The number of lines of the scaled image.
+      \param nScaledCols  The number of columns of the scaled image.
+    */
+    void rebuildPixelRuns(const std::size_t& scale, const std::size_t& nScaledLines, const std::size_t& nScaledCols);
+
+    std::size_t getNumberOfThreads() const;
 
     //@}
 
@@ -246,6 +368,76 @@ class MSEGEXPORT MultiSeg : public TePDIAlgorithm
     /*! \brief This method notifies for each registered outputter the MultiSeg results. */
     void notifyResult();
 
+  private:
+
+    /*!
+      \struct StatisticsAccumulator
+
+      \brief The sufficient statistics of the regions over a strip of image lines, indexed by the position of the region on the live regions.
+
+      The squared deviations of each band are accumulated around the first value of the region on the strip
+      (shifted data), so the variance does not suffer the cancellation of the raw sum of squares. The cubed
+      and fourth powers of the deviations are accumulated the same way, if the higher order moments are tracked.
+      The pixel runs of the strip, and the pixel pairs of each pixel with its right and down neighbours, are
+      collected on the same sweep, if they are tracked.
+    */
+    struct StatisticsAccumulator
+    {
+      std::size_t m_nBands;               //!< The number of bands.
+      std::vector<std::size_t> m_counts;  //!< The number of pixels of each region.
+      std::vector<double> m_sums;         //!< The sum of the pixel values of each region and band.
+      std::vector<double> m_shifts;       //!< The first pixel value of each region and band.
+      std::vector<double> m_squares;      //!< The sum of the squared differences to the shift of each region and band.
+      std::vector<double> m_cubes;        //!< The sum of the cubed differences to the shift of each region and band, if the higher order moments are tracked.
+      std::vector<double> m_quartics;     //!< The sum of the fourth powers of the differences to the shift of each region and band, if the higher order moments are tracked.
+      std::vector<std::size_t> m_nPairs;  //!< The number of pixel pairs inside each region, if the pixel pairs are tracked.
+      std::vector<double> m_pairSquares;  //!< The sum of the squared differences of the pixel pairs inside each region and band, if the pixel pairs are tracked.
+      BoundaryTable m_boundaries;         //!< The pixel pairs across the boundaries of the regions, if the pixel pairs are tracked.
+      std::vector<double> m_pairBuffer;   //!< Buffer reused to compute the squared differences of a pixel pair.
+      std::vector<std::pair<std::size_t, PixelRun> > m_runs; //!< The pixel runs of the strip, in image order, with the position of their regions.
+
+      /*! \brief This method clears the accumulator to the given number of regions and bands, and the statistics that are tracked. */
+      void reset(const std::size_t& nRegions, const std::size_t& nBands, bool higherMoments, bool pixelPairs);
+
+      /*! \brief This method adds the given pixel to the region at the given position. */
+      void add(const std::size_t& index, const double* pixel);
+
+      /*! \brief This method adds the pixel pair of two neighbour pixels, given their region positions and identifiers. */
+      void addPair(const std::size_t& index1, const std::size_t& id1, const PixelBuffer::Value* pixel1,
+                   const std::size_t& index2, const std::size_t& id2, const PixelBuffer::Value* pixel2);
+    };
+
+    /*! \brief This method accumulates the statistics, and the pixel runs if they are tracked, of the pixels of the lines [linStart, linBound) of the given image. */
+    void accumulateRegionStatistics(const PixelBuffer& image,
+                                    const std::size_t& linStart, const std::size_t& linBound,
+                                    StatisticsAccumulator& accumulator, TePDIPIManager* progress);
+
+  private:
+
+    /*!
+      \struct MergeCandidate
+
+      \brief A candidate merge of the region growing priority queue.
+
+      The candidate is stale if the epoch of its region was increased after it was queued.
+    */
+    struct MergeCandidate
+    {
+      double m_distance;      //!< The euclidean distance between the region and its closest neighbour.
+      std::size_t m_regionId; //!< The region identifier.
+      std::size_t m_epoch;    //!< The epoch of the region when the candidate was queued.
+      Region* m_closest;      //!< The closest neighbour of the region.
+
+      /*! \brief Reversed order, so the std::priority_queue top is the lowest distance (the lowest identifier on ties). */
+      bool operator<(const MergeCandidate& rhs) const
+      {
+        if(m_distance != rhs.m_distance)
+          return m_distance > rhs.m_distance;
+
+        return m_regionId > rhs.m_regionId;
+      }
+    };
+
   private:
 
     /** @name Parameters
@@ -265,22 +457,29 @@ class MSEGEXPORT MultiSeg : public TePDIAlgorithm
     double m_similarity;                                //!< Expressed in dB case ImageType == Radar or gray scale case ImageType == Optical.
     std::size_t m_minArea;                              //!< Region pixel size minimum value.
     double m_ENL;                                       //!< Number of looks. Required when ImageType == Radar and ImageModelRepresentation == Cartoon.
-    double m_confidenceLevel;                           //!< Required when ImageType == Radar and ImageModelRepresentation == Texture. Or ImageType == Optical.
+    double m_confidenceLevel;                           //!< Required when ImageType == Radar or ImageType == Optical.
     double m_cv;                                        //!< Coefficient of variation. Required when ImageType == Radar and ImageModelRepresentation == Texture. Or ImageType == Optical.
+    RegionGrowingStrategy m_regionGrowingStrategy;      //!< Defines how the candidate merges are searched - (Passes or PriorityQueue).
     
     //@}
 
-    TePDITypes::TePDIRasterPtrType  m_labelledImage;    //!< The labelled image that will be generated.
-    std::map<std::size_t, Region*> m_regions;           //!< The set of regions.
+    LabelBuffer m_labels;                               //!< The labels of the image pixels. i.e. the regions identifiers.
+    TePDITypes::TePDIRasterPtrType  m_labelledImage;    //!< The labelled image that will be generated. It is updated from m_labels when the results are notified.
+    RegionTable m_regions;                              //!< The set of regions.
+    RegionPool* m_regionPool;                           //!< The arena that allocates the regions.
 
     AbstractMerger* m_merger;                           //!< The merge that will be used.
+    std::vector<Region*> m_closestRegions;              //!< Buffer reused by getClosestRegion() to gather the candidates.
+    std::vector<double> m_closestDistances;             //!< Buffer reused by getClosestRegion() to compute the candidates distances.
+    std::vector<unsigned char> m_closestPasses;         //!< Buffer reused by getClosestRegions() to evaluate the candidates predicates.
+    std::size_t m_closestEpoch;                         //!< The epoch of the cached closest neighbours. Increasing it discards all of them.
+    std::priority_queue<MergeCandidate> m_candidates;   //!< The candidate merges of the priority queue region growing.
 
     CVTable m_cvTable;                                  //!< The table of Coefficient of Variation.
 
     std::size_t m_similarityIncreaseStep;
     bool m_enableMutualBestFitting;                     //!< A flag that indicates if the mutual best fitting is necessary to merging two regions.
     bool m_growUntilStop;                               //!< A flag that indicates if the region grows until stop during the region growing process.
-    std::size_t m_nSamples;                             //!< The number of samples used to compute region statistics.
     bool m_considerRegionVsRegion;                      //!< A flag that indicates if the region vs. region tests is considered or not.
 
     std::size_t m_currentLevel;                         //!< The current level being segmented.
@@ -293,6 +492,19 @@ class MSEGEXPORT MultiSeg : public TePDIAlgorithm
 
     bool m_outputPyramid;                               //!< A flag that indicates if the image hierarchical pyramid must be outputted.
     bool m_notifyIntermediateResults;                   //!< A flag that indicates if the intermediate results must be outputted.
+    bool m_deferLabelUpdates;                           //!< A flag that indicates if the relabelling of the merged regions pixels is deferred.
+    bool m_trackPixelRuns;                              //!< A flag that indicates if the pixel runs of the regions are maintained.
+    bool m_cacheClosestRegions;                         //!< A flag that indicates if the closest neighbour of each region is cached.
+    std::size_t m_nThreads;                             //!< The number of threads used by the image sweeps. 0 means the number of available processors.
+    std::size_t m_pyramidMemoryBudget;                  //!< The maximum number of bytes of the pyramid levels held in memory. 0 means no limit.
+    std::string m_pyramidCacheDirectory;                //!< The directory of the pyramid cache files. Empty means no cache.
+    std::vector<StatisticsAccumulator> m_accumulators;  //!< The statistics accumulators of each strip. Reused by each statistics update.
+    std::vector<std::size_t> m_accumulatorIndices;      //!< The position of each region identifier on the live regions, or std::string::npos. Reused by each statistics update.
+    std::vector<PixelRun> m_pixelRuns;                  //!< Buffer reused to get the pixel runs of a region.
+    bool m_trackHigherMoments;                          //!< A flag that indicates if the third and fourth central moments of the regions are maintained. i.e. the merger reads them.
+    bool m_trackCooccurrences;                          //!< A flag that indicates if the pixel pairs of the regions are maintained. i.e. the merger reads their contrast.
+    BoundaryTable m_boundaries;                         //!< The pixel pairs across the boundary of each pair of neighbour regions, if the pixel pairs are tracked.
+    std::vector<double> m_pairSquares;                  //!< Buffer reused to get the squared differences of the pixel pairs.
 };
 
 #endif // __MULTISEG_INTERNAL_MULTISEG_H
@@ -0,0 +1,288 @@
+/*  Copyright (C) 2014 National Institute For Space Research (INPE) - Brazil.
+
+    MultiSeg is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    MultiSeg is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with MultiSeg. See COPYING.
+ */
+
+/*!
+  \file Neighbourhood.cpp
+
+  \brief This class implements a compact set of neighbour regions.
+
+  \author Douglas Uba <douglas@dpi.inpe.br>
+*/
+
+// MultiSeg
+#include "Neighbourhood.h"
+
+// STL
+#include <cassert>
+#include <string>
+
+Neighbourhood::const_iterator::const_iterator()
+  : m_pos(0),
+    m_end(0)
+{
+}
+
+Neighbourhood::const_iterator::const_iterator(Region* const* pos, Region* const* end)
+  : m_pos(pos),
+    m_end(end)
+{
+}
+
+Neighbourhood::Neighbourhood()
+  : m_items(m_inline),
+    m_capacity(sm_inlineCapacity),
+    m_end(0),
+    m_size(0),
+    m_index(0),
+    m_indexMask(0)
+{
+}
+
+Neighbourhood::~Neighbourhood()
+{
+  clear();
+}
+
+bool Neighbourhood::insert(Region* region)
+{
+  assert(region);
+
+  if(find(region) != std::string::npos)
+    return false;
+
+  reserve();
+
+  m_items[m_end] = region;
+
+  if(m_index)
+    indexInsert(region, m_end);
+
+  ++m_end;
+  ++m_size;
+
+  // The set became large. Linear searches are not worth anymore
+  if(m_index == 0 && m_size > sm_indexThreshold)
+    buildIndex();
+
+  return true;
+}
+
+bool Neighbourhood::remove(Region* region)
+{
+  std::size_t pos = find(region);
+  if(pos == std::string::npos)
+    return false;
+
+  if(m_index)
+    indexRemove(region);
+
+  // Leaves a hole, so the order and the positions of the others neighbours are kept
+  m_items[pos] = 0;
+  --m_size;
+
+  // Trailing holes are reclaimed right now
+  while(m_end > 0 && m_items[m_end - 1] == 0)
+    --m_end;
+
+  return true;
+}
+
+bool Neighbourhood::contains(Region* region) const
+{
+  return find(region) != std::string::npos;
+}
+
+void Neighbourhood::clear()
+{
+  if(m_items != m_inline)
+    delete [] m_items;
+
+  delete [] m_index;
+
+  m_items = m_inline;
+  m_capacity = sm_inlineCapacity;
+  m_end = 0;
+  m_size = 0;
+  m_index = 0;
+  m_indexMask = 0;
+}
+
+Neighbourhood::const_iterator Neighbourhood::begin() const
+{
+  const_iterator it(m_items, m_items + m_end);
+
+  // Skips the leading holes
+  if(m_end > 0 && m_items[0] == 0)
+    ++it;
+
+  return it;
+}
+
+Neighbourhood::const_iterator Neighbourhood::end() const
+{
+  return const_iterator(m_items + m_end, m_items + m_end);
+}
+
+std::size_t Neighbourhood::find(Region* region) const
+{
+  if(m_index)
+  {
+    for(std::size_t i = hash(region); m_index[i].m_region != 0; i = (i + 1) & m_indexMask)
+    {
+      if(m_index[i].m_region == region)
+        return m_index[i].m_pos;
+    }
+
+    return std::string::npos;
+  }
+
+  for(std::size_t pos = 0; pos < m_end; ++pos)
+  {
+    if(m_items[pos] == region)
+      return pos;
+  }
+
+  return std::string::npos;
+}
+
+void Neighbourhood::reserve()
+{
+  if(m_end < m_capacity)
+    return;
+
+  // At least half of the positions are holes. Reclaiming them is enough
+  if(m_size <= m_capacity / 2)
+  {
+    compact();
+    return;
+  }
+
+  // Grows the buffer, removing the holes
+  std::size_t capacity = m_capacity * 2;
+  Region** items = new Region*[capacity];
+
+  std::size_t n = 0;
+  for(std::size_t pos = 0; pos < m_end; ++pos)
+  {
+    if(m_items[pos] != 0)
+      items[n++] = m_items[pos];
+  }
+
+  assert(n == m_size);
+
+  if(m_items != m_inline)
+    delete [] m_items;
+
+  m_items = items;
+  m_capacity = capacity;
+  m_end = m_size;
+
+  if(m_index)
+    buildIndex();
+}
+
+void Neighbourhood::compact()
+{
+  std::size_t n = 0;
+  for(std::size_t pos = 0; pos < m_end; ++pos)
+  {
+    if(m_items[pos] != 0)
+      m_items[n++] = m_items[pos];
+  }
+
+  assert(n == m_size);
+
+  m_end = m_size;
+
+  if(m_index)
+    buildIndex();
+}
+
+void Neighbourhood::buildIndex()
+{
+  delete [] m_index;
+
+  // Keeps the load factor at most 0.5 until the next growth of the buffer
+  std::size_t nBuckets = 1;
+  while(nBuckets < m_capacity * 2)
+    nBuckets <<= 1;
+
+  m_index = new Bucket[nBuckets];
+  m_indexMask = nBuckets - 1;
+
+  for(std::size_t i = 0; i < nBuckets; ++i)
+    m_index[i].m_region = 0;
+
+  for(std::size_t pos = 0; pos < m_end; ++pos)
+  {
+    if(m_items[pos] != 0)
+      indexInsert(m_items[pos], pos);
+  }
+}
+
+void Neighbourhood::indexInsert(Region* region, const std::size_t& pos)
+{
+  assert(m_index);
+
+  std::size_t i = hash(region);
+  while(m_index[i].m_region != 0)
+    i = (i + 1) & m_indexMask;
+
+  m_index[i].m_region = region;
+  m_index[i].m_pos = pos;
+}
+
+void Neighbourhood::indexRemove(Region* region)
+{
+  assert(m_index);
+
+  std::size_t i = hash(region);
+  while(m_index[i].m_region != region)
+  {
+    assert(m_index[i].m_region != 0);
+    i = (i + 1) & m_indexMask;
+  }
+
+  // Backward shift deletion: moves back the next buckets of the probe sequence, so no tombstones are needed
+  std::size_t j = i;
+  while(true)
+  {
+    j = (j + 1) & m_indexMask;
+
+    if(m_index[j].m_region == 0)
+      break;
+
+    std::size_t k = hash(m_index[j].m_region);
+
+    // Is the home bucket k cyclically in (i, j]? So the bucket j must stay where it is
+    if(i <= j ? (i < k && k <= j) : (i < k || k <= j))
+      continue;
+
+    m_index[i] = m_index[j];
+    i = j;
+  }
+
+  m_index[i].m_region = 0;
+}
+
+std::size_t Neighbourhood::hash(Region* region) const
+{
+  std::size_t h = reinterpret_cast<std::size_t>(region) >> 3;
+  h *= 2654435761u;
+  h ^= h >> 15;
+
+  return h & m_indexMask;
+}
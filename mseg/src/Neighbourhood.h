@@ -0,0 +1,235 @@
+/*  Copyright (C) 2014 National Institute For Space Research (INPE) - Brazil.
+
+    MultiSeg is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    MultiSeg is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with MultiSeg. See COPYING.
+ */
+
+/*!
+  \file Neighbourhood.h
+
+  \brief This class implements a compact set of neighbour regions.
+
+  \author Douglas Uba <douglas@dpi.inpe.br>
+*/
+
+#ifndef __MULTISEG_INTERNAL_NEIGHBOURHOOD_H
+#define __MULTISEG_INTERNAL_NEIGHBOURHOOD_H
+
+// MultiSeg
+#include "Config.h"
+
+// STL
+#include <cstddef>
+#include <iterator>
+
+// Forward declaration
+class Region;
+
+/*!
+  \class Neighbourhood
+
+  \brief This class implements a compact set of neighbour regions.
+
+  The neighbours are stored contiguously in insertion order. The first neighbours fit on an inline
+  buffer, so a pixel region does not allocate memory for its (up to four) neighbours. Small sets are
+  searched linearly. When the set grows beyond a threshold, an open addressing hash index that maps
+  each neighbour to its position is built, and removals leave a hole that is skipped by the iteration
+  and reclaimed on the next compaction. Thus, insert, remove and membership are O(1) amortized.
+
+  \note The insertion order is preserved, so the iteration visits the neighbours in the same order
+        they were added.
+
+  \note Removing a neighbour invalidates only the iterators of this set that point to it.
+        Inserting a neighbour invalidates all iterators of this set.
+*/
+class MSEGEXPORT Neighbourhood
+{
+  public:
+
+    /*!
+      \class const_iterator
+
+      \brief Forward iterator over the neighbours, in insertion order.
+    */
+    class const_iterator
+    {
+      public:
+
+        typedef std::forward_iterator_tag iterator_category;
+        typedef Region* value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef Region* const* pointer;
+        typedef Region* reference;
+
+        const_iterator();
+
+        const_iterator(Region* const* pos, Region* const* end);
+
+        Region* operator*() const;
+
+        const_iterator& operator++();
+
+        bool operator==(const const_iterator& rhs) const;
+
+        bool operator!=(const const_iterator& rhs) const;
+
+      private:
+
+        Region* const* m_pos; //!< The current position.
+        Region* const* m_end; //!< The end of the iterated positions.
+    };
+
+    typedef const_iterator iterator;
+
+    /*! \brief Default constructor. */
+    Neighbourhood();
+
+    /*! \brief Destructor. */
+    ~Neighbourhood();
+
+    /*!
+      \brief This method adds the given region to the set. Nothing is done if it is already there.
+
+      \param region The region that will be added.
+
+      \return It returns true if the region was added and false if it was already there.
+    */
+    bool insert(Region* region);
+
+    /*!
+      \brief This method removes the given region from the set. Nothing is done if it is not there.
+
+      \param region The region that will be removed.
+
+      \return It returns true if the region was removed and false if it was not there.
+    */
+    bool remove(Region* region);
+
+    /*!
+      \brief This method returns if the given region is on the set.
+
+      \param region The region that will be searched.
+
+      \return It returns true if the given region is on the set and false otherwise.
+    */
+    bool contains(Region* region) const;
+
+    /*!
+      \brief This method returns the number of neighbours.
+
+      \return The number of neighbours.
+    */
+    std::size_t size() const;
+
+    /*!
+      \brief This method returns if the set has no neighbours.
+
+      \return It returns true if the set has no neighbours and false otherwise.
+    */
+    bool empty() const;
+
+    /*! \brief This method removes all neighbours and releases the memory. */
+    void clear();
+
+    const_iterator begin() const;
+
+    const_iterator end() const;
+
+  private:
+
+    /*! \brief This method returns the position of the given region or std::string::npos if it is not on the set. */
+    std::size_t find(Region* region) const;
+
+    /*! \brief This method ensures that there is room to append a new neighbour. */
+    void reserve();
+
+    /*! \brief This method removes the holes and rebuilds the hash index, if any. */
+    void compact();
+
+    /*! \brief This method (re)builds the hash index from the stored neighbours. */
+    void buildIndex();
+
+    /*! \brief This method adds the given position to the hash index. */
+    void indexInsert(Region* region, const std::size_t& pos);
+
+    /*! \brief This method removes the given region from the hash index. */
+    void indexRemove(Region* region);
+
+    /*! \brief This method returns the hash index bucket of the given region. */
+    std::size_t hash(Region* region) const;
+
+    /*! \brief No copy allowed. */
+    Neighbourhood(const Neighbourhood& rhs);
+
+    /*! \brief No copy allowed. */
+    Neighbourhood& operator=(const Neighbourhood& rhs);
+
+  private:
+
+    static const std::size_t sm_inlineCapacity = 4;  //!< The number of neighbours stored without memory allocation.
+    static const std::size_t sm_indexThreshold = 16; //!< The number of neighbours from which the hash index is used.
+
+    /*! \brief The hash index bucket. */
+    struct Bucket
+    {
+      Region* m_region;  //!< The indexed region. NULL means an empty bucket.
+      std::size_t m_pos; //!< The position of the indexed region.
+    };
+
+    Region* m_inline[sm_inlineCapacity]; //!< The inline buffer.
+    Region** m_items;                    //!< The stored neighbours. NULL means a hole.
+    std::size_t m_capacity;              //!< The capacity of the stored neighbours buffer.
+    std::size_t m_end;                   //!< The number of used positions, including the holes.
+    std::size_t m_size;                  //!< The number of neighbours.
+    Bucket* m_index;                     //!< The hash index. NULL while the set is small.
+    std::size_t m_indexMask;             //!< The number of hash index buckets minus one.
+};
+
+inline Region* Neighbourhood::const_iterator::operator*() const
+{
+  return *m_pos;
+}
+
+inline Neighbourhood::const_iterator& Neighbourhood::const_iterator::operator++()
+{
+  // Skips the holes
+  do
+  {
+    ++m_pos;
+  }
+  while(m_pos != m_end && *m_pos == 0);
+
+  return *this;
+}
+
+inline bool Neighbourhood::const_iterator::operator==(const const_iterator& rhs) const
+{
+  return m_pos == rhs.m_pos;
+}
+
+inline bool Neighbourhood::const_iterator::operator!=(const const_iterator& rhs) const
+{
+  return m_pos != rhs.m_pos;
+}
+
+inline std::size_t Neighbourhood::size() const
+{
+  return m_size;
+}
+
+inline bool Neighbourhood::empty() const
+{
+  return m_size == 0;
+}
+
+#endif // __MULTISEG_INTERNAL_NEIGHBOURHOOD_H
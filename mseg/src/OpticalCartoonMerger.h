@@ -29,6 +29,10 @@
 #include "Config.h"
 #include "EuclideanMerger.h"
 
+// STL
+#include <cassert>
+#include <cmath>
+
 /*!
   \class OpticalCartoonMerger
 
@@ -46,11 +50,91 @@ class MSEGEXPORT OpticalCartoonMerger : public EuclideanMerger
     /*! \brief Destructor. */
     ~OpticalCartoonMerger();
 
+    bool predicate(Region* r1, Region* r2) const;
+
+    double getDissimilarity(const std::vector<double>& p, Region* r) const;
+
+    std::size_t predicates(Region* region, const std::vector<Region*>& regions,
+                           std::vector<unsigned char>& passes, std::vector<double>& distances) const;
+
   protected:
 
     bool predicate(Region* r1, Region* r2, const std::size_t& band) const;
 
     double getDissimilarity(const std::vector<double>& p, Region* r, const std::size_t& band) const;
+
+  friend class AbstractMerger;
 };
 
+inline bool OpticalCartoonMerger::predicate(Region* r1, Region* r2, const std::size_t& band) const
+{
+  assert(r1);
+  assert(r2);
+  assert(r1->getNBands() ==  r2->getNBands());
+
+  // pixel vs. pixel or pixel vs. region
+  if(r1->getSize() == 1)
+    return EuclideanMerger::predicate(r1, r2, band);
+
+  // Gets the regions mean
+  const Region::Statistic* mean1 = r1->getMean();
+  const Region::Statistic* mean2 = r2->getMean();
+
+  assert(band < r1->getNBands());
+
+  // Gets the mean A from given band
+  double meanA = mean1[band];
+
+  // Gets the mean B from given band
+  double meanB = mean2[band];
+
+  assert(band < m_paramBlock.m_imageVariances.size());
+
+  // Image total variance of band b-th
+  double totalVariance = m_paramBlock.m_imageVariances[band];
+
+  // region vs. pixel
+  if(r1->getSize() > 1 && r2->getSize() == 1)
+  {
+    double zValue = std::abs(meanA - meanB) / m_paramBlock.m_imageStdDevs[band];
+
+    // p = 1 - cdf(zValue) >= 1 - confidence_level. i.e. zValue is not greater than the critical value
+    if(zValue <= m_paramBlock.m_criticalValues.getZ())
+      return true;
+    else
+      return false;
+  }
+
+  // region vs. region
+  assert(r1->getSize() > 1 && r2->getSize() > 1);
+
+  // Degrees of Freedom (t-Student)
+  std::size_t dof = r1->getSize() + r2->getSize() - 2;
+
+  double rootVariance = sqrt(totalVariance * ((1.0 / static_cast<double>(r1->getSize())) + (1.0 / static_cast<double>(r2->getSize()))));
+  
+  assert(rootVariance != 0.0);
+
+  double tValue = std::abs(meanA - meanB) / rootVariance;
+
+  // p = 1 - cdf(tValue) >= 1 - confidence_level. i.e. tValue is not greater than the critical value
+  if(tValue <= m_paramBlock.m_criticalValues.getT(dof))
+    return true;
+  else
+    return false;
+}
+
+inline double OpticalCartoonMerger::getDissimilarity(const std::vector<double>& p, Region* r, const std::size_t& band) const
+{
+  assert(band < m_paramBlock.m_imageVariances.size());
+
+  // Image total variance of band b-th
+  double totalVariance = m_paramBlock.m_imageVariances[band];
+
+  // Gets the squared euclidean distance between the pixel and the region
+  double distance = EuclideanMerger::getDissimilarity(p, r, band);
+
+  return distance / totalVariance;
+}
+
 #endif // __MULTISEG_INTERNAL_OPTICALCARTOONMERGER_H
@@ -0,0 +1,90 @@
+/*  Copyright (C) 2014 National Institute For Space Research (INPE) - Brazil.
+
+    MultiSeg is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    MultiSeg is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with MultiSeg. See COPYING.
+ */
+
+
+/*!
+  \file OpticalTextureMerger.cpp
+
+  \brief This class implements the merger to optical texture images.
+
+  \author Douglas Uba <douglas@dpi.inpe.br>
+*/
+
+// MultiSeg
+#include "OpticalTextureMerger.h"
+#include "Region.h"
+
+// STL
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+OpticalTextureMerger::OpticalTextureMerger()
+  : TextureMerger()
+{
+}
+
+OpticalTextureMerger::~OpticalTextureMerger()
+{
+}
+
+bool OpticalTextureMerger::usesCooccurrences() const
+{
+  return true;
+}
+
+bool OpticalTextureMerger::compareTexture(Region* r1, Region* r2, const std::size_t& band) const
+{
+  // Gets the variances
+  double varianceA = r1->getVariance()[band];
+  double varianceB = r2->getVariance()[band];
+
+  // Regions without texture are homogeneous only with each other
+  if(varianceA == 0.0 || varianceB == 0.0)
+    return varianceA == varianceB;
+
+  const double criticalValue = m_paramBlock.m_criticalValues.getZ();
+
+  // Standard error of the log of the variances ratio
+  double rootVarianceAB = sqrt((2.0 / (r1->getSize() - 1.0)) + (2.0 / (r2->getSize() - 1.0)));
+
+  double zValue = std::abs(log(varianceA / varianceB)) / rootVarianceAB;
+
+  // p = 1 - cdf(zValue) >= 1 - confidence_level. i.e. zValue is not greater than the critical value
+  if(zValue > criticalValue)
+    return false;
+
+  // The pixel pairs are not tracked or they are too few to estimate the correlations
+  if(r1->getContrast() == 0 || r2->getContrast() == 0 || r1->getNPairs() <= 3 || r2->getNPairs() <= 3)
+    return true;
+
+  // Lag 1 correlations, from the contrasts
+  double rhoA = std::max(-0.999, std::min(0.999, 1.0 - r1->getContrast()[band] / (2.0 * varianceA)));
+  double rhoB = std::max(-0.999, std::min(0.999, 1.0 - r2->getContrast()[band] / (2.0 * varianceB)));
+
+  // Fisher transformation: atanh(rho) = 0.5 * log((1 + rho) / (1 - rho))
+  double fisherA = 0.5 * log((1.0 + rhoA) / (1.0 - rhoA));
+  double fisherB = 0.5 * log((1.0 + rhoB) / (1.0 - rhoB));
+
+  double rootFisherAB = sqrt((1.0 / (r1->getNPairs() - 3.0)) + (1.0 / (r2->getNPairs() - 3.0)));
+
+  zValue = std::abs(fisherA - fisherB) / rootFisherAB;
+
+  if(zValue <= criticalValue)
+    return true;
+  else
+    return false;
+}
@@ -0,0 +1,64 @@
+/*  Copyright (C) 2014 National Institute For Space Research (INPE) - Brazil.
+
+    MultiSeg is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    MultiSeg is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with MultiSeg. See COPYING.
+ */
+
+/*!
+  \file OpticalTextureMerger.h
+
+  \brief This class implements the merger to optical texture images.
+
+  \author Douglas Uba <douglas@dpi.inpe.br>
+*/
+
+#ifndef __MULTISEG_INTERNAL_OPTICALTEXTUREMERGER_H
+#define __MULTISEG_INTERNAL_OPTICALTEXTUREMERGER_H
+
+// MutiSeg
+#include "Config.h"
+#include "TextureMerger.h"
+
+/*!
+  \class OpticalTextureMerger
+
+  \brief This class implements the merger to optical texture images.
+
+  The texture of a region is described by the variance and the contrast of each band. Under the additive
+  model, both are independent of the region mean. The contrast is the mean squared difference of the
+  neighbour pixel pairs of the region, so the lag 1 correlation of the region is 1 - contrast / (2 * variance).
+
+  Two regions are homogeneous if neither their variances nor their correlations are significantly different
+  (log variance ratio and Fisher z tests). The variance and the pixel pairs are mergeable statistics, so a
+  merge is O(bands), plus the boundaries of the merged region.
+
+  \sa AbstractMerger, TextureMerger, OpticalCartoonMerger, CompositeMerger
+*/
+class MSEGEXPORT OpticalTextureMerger : public TextureMerger
+{
+  public:
+
+    /*! \brief Default constructor. */
+    OpticalTextureMerger();
+
+    /*! \brief Destructor. */
+    ~OpticalTextureMerger();
+
+    bool usesCooccurrences() const;
+
+  protected:
+
+    bool compareTexture(Region* r1, Region* r2, const std::size_t& band) const;
+};
+
+#endif // __MULTISEG_INTERNAL_OPTICALTEXTUREMERGER_H
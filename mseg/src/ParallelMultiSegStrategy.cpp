@@ -66,7 +66,7 @@ bool ParallelMultiSegStrategy::execute(const RasterDataVecT& rasterDataVector, T
     {
       TeRasterParams inRasterParams;
       inRasterParams.nBands(nBands);
-      inRasterParams.setDataType(TeDOUBLE, -1);
+      inRasterParams.setDataType(MSEG_STORAGE_DATATYPE, -1);
       inRasterParams.setNLinesNColumns(nLines, nCols);
       inRasterParams.projection(m_inputProjection); // This method makes a copy of the given projection pointer.
       
@@ -165,11 +165,8 @@ bool ParallelMultiSegStrategy::setParameters(const TePDIParameters& params)
     double cv;
     params.GetParameter("cv", cv); /* ---> */ m_segParams.SetParameter("cv", cv);
 
-    if(imageType == Optical)
-    {
-      double condifenceLevel;
-      params.GetParameter("confidence_level", condifenceLevel); /* ---> */ m_segParams.SetParameter("confidence_level", condifenceLevel);
-    }
+    double condifenceLevel;
+    params.GetParameter("confidence_level", condifenceLevel); /* ---> */ m_segParams.SetParameter("confidence_level", condifenceLevel);
   }
 
   return true;
@@ -224,11 +221,8 @@ bool ParallelMultiSegStrategy::checkParameters(const TePDIParameters& params)
     double cv; // Need Coefficient of variation.
     TEAGN_TRUE_OR_RETURN(params.GetParameter("cv", cv), TR_TERRALIB("Missing parameter: cv"));
     
-    if(type == Optical)
-    {
-      double confidenceLevel; // Need confidence_level
-      TEAGN_TRUE_OR_RETURN(params.GetParameter("confidence_level", confidenceLevel), TR_TERRALIB("Missing parameter: confidence_level"));
-    }
+    double confidenceLevel; // Need confidence_level
+    TEAGN_TRUE_OR_RETURN(params.GetParameter("confidence_level", confidenceLevel), TR_TERRALIB("Missing parameter: confidence_level"));
   }
 
   TEAGN_TRUE_OR_RETURN(params.GetParameter("input_projection", m_inputProjection), TR_TERRALIB("Missing parameter: input_projection"));
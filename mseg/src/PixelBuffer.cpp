@@ -0,0 +1,108 @@
+/*  Copyright (C) 2014 National Institute For Space Research (INPE) - Brazil.
+
+    MultiSeg is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    MultiSeg is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with MultiSeg. See COPYING.
+ */
+
+
+/*!
+  \file PixelBuffer.cpp
+
+  \brief This class implements an in-memory multi-band image, band-interleaved by pixel.
+
+  \author Douglas Uba <douglas@dpi.inpe.br>
+*/
+
+// MultiSeg
+#include "PixelBuffer.h"
+
+// TerraLib
+#include <terralib/image_processing/TePDIUtils.hpp>
+#include <terralib/kernel/TeAgnostic.h>
+#include <terralib/kernel/TeRaster.h>
+
+PixelBuffer::PixelBuffer()
+  : m_nLines(0),
+    m_nCols(0),
+    m_nBands(0),
+    m_data(0)
+{
+}
+
+PixelBuffer::~PixelBuffer()
+{
+}
+
+void PixelBuffer::reset(const TeRasterParams& params)
+{
+  m_params = params;
+
+  m_nLines = params.nlines_;
+  m_nCols = params.ncols_;
+  m_nBands = params.nBands();
+
+  m_values.resize(m_nLines * m_nCols * m_nBands);
+
+  m_data = m_values.empty() ? 0 : &m_values[0];
+}
+
+void PixelBuffer::attach(const TeRasterParams& params, Value* values)
+{
+  clear();
+
+  m_params = params;
+
+  m_nLines = params.nlines_;
+  m_nCols = params.ncols_;
+  m_nBands = params.nBands();
+
+  m_data = values;
+}
+
+void PixelBuffer::clear()
+{
+  std::vector<Value>().swap(m_values);
+
+  m_data = 0;
+}
+
+const TeRasterParams& PixelBuffer::getParams() const
+{
+  return m_params;
+}
+
+std::size_t PixelBuffer::getBytes() const
+{
+  return m_values.capacity() * sizeof(Value);
+}
+
+TePDITypes::TePDIRasterPtrType PixelBuffer::createRaster() const
+{
+  assert(!isEmpty());
+
+  TePDITypes::TePDIRasterPtrType raster;
+  TEAGN_TRUE_OR_THROW(TePDIUtils::TeAllocRAMRaster(m_params, raster), "Error creating the image.");
+
+  for(std::size_t lin = 0; lin < m_nLines; ++lin)
+  {
+    const Value* line = getLine(lin);
+
+    for(std::size_t col = 0; col < m_nCols; ++col)
+    {
+      for(std::size_t b = 0; b < m_nBands; ++b)
+        raster->setElement(col, lin, static_cast<double>(line[col * m_nBands + b]), b);
+    }
+  }
+
+  return raster;
+}
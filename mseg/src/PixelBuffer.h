@@ -0,0 +1,228 @@
+/*  Copyright (C) 2014 National Institute For Space Research (INPE) - Brazil.
+
+    MultiSeg is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    MultiSeg is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with MultiSeg. See COPYING.
+ */
+
+
+/*!
+  \file PixelBuffer.h
+
+  \brief This class implements an in-memory multi-band image, band-interleaved by pixel.
+
+  \author Douglas Uba <douglas@dpi.inpe.br>
+*/
+
+#ifndef __MULTISEG_INTERNAL_PIXELBUFFER_H
+#define __MULTISEG_INTERNAL_PIXELBUFFER_H
+
+// MultiSeg
+#include "Config.h"
+
+// TerraLib
+#include <terralib/image_processing/TePDITypes.hpp>
+#include <terralib/kernel/TeRasterParams.h>
+
+// STL
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+/*!
+  \class PixelBuffer
+
+  \brief This class implements an in-memory multi-band image, band-interleaved by pixel (BIP).
+
+  The values of all bands of a pixel are contiguous, and the pixels are stored on one contiguous buffer,
+  line by line. So, the multi-band reads of the segmentation (a pixel at a time) are cache-friendly and
+  do not need virtual calls.
+
+  The buffer keeps the raster parameters of the image that it stores. i.e. its geometry, its number of bands
+  and the data type of each band. The values are stored as PixelBuffer::Value, but they are the values that a raster
+  of these data types would store. A TerraLib raster is created only when it is required. e.g. to output the image.
+
+  The values may also be held by someone else, e.g. a memory-mapped file. See attach().
+*/
+class MSEGEXPORT PixelBuffer
+{
+  public:
+
+    /*! \brief The storage type of the values. \sa MSEGFLOAT32 */
+#ifdef MSEGFLOAT32
+    typedef float Value;
+#else
+    typedef double Value;
+#endif
+
+    /*! \brief Default constructor. It creates an empty buffer. */
+    PixelBuffer();
+
+    /*! \brief Destructor. */
+    ~PixelBuffer();
+
+    /*!
+      \brief This method (re)allocates the buffer to the given raster parameters. The values are undefined.
+
+      \param params The raster parameters. The geometry, the number of bands and the data types are considered.
+    */
+    void reset(const TeRasterParams& params);
+
+    /*!
+      \brief This method makes the buffer a view of values that it does not own. The owned values are released.
+
+      \param params The raster parameters. The geometry, the number of bands and the data types are considered.
+      \param values The values, line by line and pixel by pixel. They must stay valid while they are attached.
+    */
+    void attach(const TeRasterParams& params, Value* values);
+
+    /*! \brief This method releases the values, or detaches them. The raster parameters are kept. */
+    void clear();
+
+    /*!
+      \brief This method returns if the buffer has no values. e.g. if it was released.
+
+      \return It returns true if the buffer has no values and false otherwise.
+    */
+    bool isEmpty() const;
+
+    /*!
+      \brief This method returns the raster parameters of the stored image.
+
+      \return The raster parameters of the stored image.
+    */
+    const TeRasterParams& getParams() const;
+
+    /*!
+      \brief This method returns the number of lines.
+
+      \return The number of lines.
+    */
+    std::size_t getNLines() const;
+
+    /*!
+      \brief This method returns the number of columns.
+
+      \return The number of columns.
+    */
+    std::size_t getNCols() const;
+
+    /*!
+      \brief This method returns the number of bands.
+
+      \return The number of bands.
+    */
+    std::size_t getNBands() const;
+
+    /*!
+      \brief This method returns the values of the given line.
+
+      \param lin The line.
+
+      \return The getNCols() * getNBands() values of the given line, pixel by pixel.
+    */
+    Value* getLine(const std::size_t& lin);
+
+    /*!
+      \brief This method returns the values of the given line.
+
+      \param lin The line.
+
+      \return The getNCols() * getNBands() values of the given line, pixel by pixel.
+    */
+    const Value* getLine(const std::size_t& lin) const;
+
+    /*!
+      \brief This method returns the values of the given pixel.
+
+      \param lin The pixel line.
+      \param col The pixel column.
+
+      \return The getNBands() values of the given pixel.
+    */
+    const Value* getPixel(const std::size_t& lin, const std::size_t& col) const;
+
+    /*!
+      \brief This method returns the number of bytes held by the buffer.
+
+      \return The number of bytes held by the buffer. The attached values are not considered.
+    */
+    std::size_t getBytes() const;
+
+    /*!
+      \brief This method creates a RAM raster with the stored values.
+
+      \return A new raster with the parameters and the values of the buffer.
+    */
+    TePDITypes::TePDIRasterPtrType createRaster() const;
+
+  private:
+
+    /*! \brief No copy allowed. */
+    PixelBuffer(const PixelBuffer& rhs);
+
+    /*! \brief No copy allowed. */
+    PixelBuffer& operator=(const PixelBuffer& rhs);
+
+  private:
+
+    TeRasterParams m_params;     //!< The raster parameters of the stored image.
+    std::size_t m_nLines;        //!< The number of lines.
+    std::size_t m_nCols;         //!< The number of columns.
+    std::size_t m_nBands;        //!< The number of bands.
+    std::vector<Value> m_values; //!< The owned values, line by line and pixel by pixel.
+    Value* m_data;               //!< The values. i.e. the owned values or the attached ones. Null if the buffer is empty.
+};
+
+inline std::size_t PixelBuffer::getNLines() const
+{
+  return m_nLines;
+}
+
+inline std::size_t PixelBuffer::getNCols() const
+{
+  return m_nCols;
+}
+
+inline std::size_t PixelBuffer::getNBands() const
+{
+  return m_nBands;
+}
+
+inline bool PixelBuffer::isEmpty() const
+{
+  return m_data == 0;
+}
+
+inline PixelBuffer::Value* PixelBuffer::getLine(const std::size_t& lin)
+{
+  assert(lin < m_nLines);
+  assert(!isEmpty());
+  return m_data + lin * m_nCols * m_nBands;
+}
+
+inline const PixelBuffer::Value* PixelBuffer::getLine(const std::size_t& lin) const
+{
+  assert(lin < m_nLines);
+  assert(!isEmpty());
+  return m_data + lin * m_nCols * m_nBands;
+}
+
+inline const PixelBuffer::Value* PixelBuffer::getPixel(const std::size_t& lin, const std::size_t& col) const
+{
+  assert(lin < m_nLines);
+  assert(col < m_nCols);
+  assert(!isEmpty());
+  return m_data + (lin * m_nCols + col) * m_nBands;
+}
+
+#endif // __MULTISEG_INTERNAL_PIXELBUFFER_H
@@ -29,34 +29,48 @@
 #include <terralib/kernel/TeRaster.h>
 #include <terralib/kernel/TeRasterRemap.h>
 #include <terralib/image_processing/TePDIPIManager.hpp>
-#include <terralib/image_processing/TePDIParameters.hpp>
 #include <terralib/image_processing/TePDIUtils.hpp>
 
 // STL
+#include <algorithm>
 #include <cassert>
+#include <cmath>
+
+const int Pyramid::sm_linesPerBlock = 64;
 
 Pyramid::Pyramid(const TePDITypes::TePDIRasterPtrType& image, const std::size_t& nLevels, const bool& progressEnabled)
-  : m_progressEnabled(progressEnabled)
+  : m_image(image),
+    m_progressEnabled(progressEnabled),
+    m_nThreads(1),
+    m_memoryBudget(0),
+    m_isBuilt(false),
+    m_inputFormat(Intensity)
 {
-  m_levels.resize(nLevels + 1);
-  m_levels[0] = image;
+  for(int b = 0; b < image->params().nBands(); ++b)
+    m_bands.push_back(b);
 
-  if(nLevels > 0)
-    build();
+  for(std::size_t i = 0; i <= nLevels; ++i)
+    m_levels.push_back(new PixelBuffer);
 }
 
-Pyramid::Pyramid(const TePDITypes::TePDIRasterPtrType& image, const std::size_t& nLevels, const std::vector<std::size_t>& bands, const bool& progressEnabled)
-  : m_bands(bands),
-    m_progressEnabled(progressEnabled)
+Pyramid::Pyramid(const TePDITypes::TePDIRasterPtrType& image, const std::size_t& nLevels, const std::vector<std::size_t>& bands,
+                 const bool& progressEnabled, const std::size_t& nThreads)
+  : m_image(image),
+    m_bands(bands),
+    m_progressEnabled(progressEnabled),
+    m_nThreads((std::max)(nThreads, static_cast<std::size_t>(1))),
+    m_memoryBudget(0),
+    m_isBuilt(false),
+    m_inputFormat(Intensity)
 {
-  m_levels.resize(nLevels + 1);
-  m_levels[0] = image;
-
-  build();
+  for(std::size_t i = 0; i <= nLevels; ++i)
+    m_levels.push_back(new PixelBuffer);
 }
 
 Pyramid::~Pyramid()
 {
+  for(std::size_t i = 0; i < m_levels.size(); ++i)
+    delete m_levels[i];
 }
 
 std::size_t Pyramid::getNLevels() const
@@ -64,16 +78,55 @@ std::size_t Pyramid::getNLevels() const
   return m_levels.size();
 }
 
-TePDITypes::TePDIRasterPtrType Pyramid::getLevel(const std::size_t& i) const
+const PixelBuffer& Pyramid::getLevel(const std::size_t& i) const
 {
   assert(i < m_levels.size());
-  return m_levels[i];
+
+  if(!m_isBuilt)
+    build();
+
+  if(m_levels[i]->isEmpty())
+  {
+    rebuildLevel(i);
+    releaseLevels(i);
+  }
+
+  return *m_levels[i];
 }
 
 void Pyramid::releaseLevel(const std::size_t& i)
 {
   assert(i < m_levels.size());
-  m_levels[i].reset(0);
+  m_levels[i]->clear();
+}
+
+void Pyramid::setMemoryBudget(const std::size_t& bytes)
+{
+  m_memoryBudget = bytes;
+
+  // The coarsest level is the first one used by the segmentation
+  if(m_isBuilt)
+    releaseLevels(m_levels.size() - 1);
+}
+
+std::size_t Pyramid::getResidentBytes() const
+{
+  std::size_t bytes = 0;
+
+  for(std::size_t i = 0; i < m_levels.size(); ++i)
+    bytes += m_levels[i]->getBytes();
+
+  return bytes;
+}
+
+void Pyramid::setCacheDirectory(const std::string& directory)
+{
+  m_cacheDirectory = directory;
+}
+
+void Pyramid::setInputFormat(const ImageFormat& format)
+{
+  m_inputFormat = format;
 }
 
 TePDITypes::TePDIRasterPtrType Pyramid::resize(TePDITypes::TePDIRasterPtrType& image,
@@ -118,113 +171,537 @@ TePDITypes::TePDIRasterPtrType Pyramid::resize(TePDITypes::TePDIRasterPtrType& l
   return TePDITypes::TePDIRasterPtrType(resized);
 }
 
-TePDIStatistic* Pyramid::buildStats(const std::size_t& i)
+double Pyramid::getMean(const std::size_t& i, const std::size_t& band) const
 {
-  assert(!m_bands.empty());
-  assert(i < m_levels.size());
+  if(!m_isBuilt)
+    build();
 
-  TePDIParameters statParams;
+  assert(i < m_statistics.size());
+  assert(band < m_bands.size());
 
-  // Input Raster & input bands
-  TePDITypes::TePDIRasterVectorType rasters;
-  std::vector<int> bands;
+  return m_statistics[i].getMean(band);
+}
 
-  for(std::size_t b = 0; b < m_bands.size(); ++b)
+double Pyramid::getVariance(const std::size_t& i, const std::size_t& band) const
+{
+  if(!m_isBuilt)
+    build();
+
+  assert(i < m_statistics.size());
+  assert(band < m_bands.size());
+
+  return m_statistics[i].getVariance(band);
+}
+
+void Pyramid::build() const
+{
+  m_statistics.resize(m_levels.size());
+  for(std::size_t i = 0; i < m_statistics.size(); ++i)
+    m_statistics[i].reset(m_bands.size());
+
+  // The levels of a previous run
+  if(openCache())
   {
-    rasters.push_back(m_levels[i]);
-    bands.push_back(m_bands[b]);
+    m_isBuilt = true;
+    return;
   }
 
-  statParams.SetParameter("rasters", rasters);
-  statParams.SetParameter("bands", bands);
+  std::vector<std::size_t> nValues;
+  for(std::size_t i = 0; i < m_levels.size() && !m_cacheDirectory.empty(); ++i)
+  {
+    TeRasterParams params = getLevelParams(i);
+    nValues.push_back(static_cast<std::size_t>(params.nlines_) * params.ncols_ * params.nBands());
+  }
 
-  TePDIStatistic* stat = new TePDIStatistic;
-  stat->ToggleProgInt(false);
-  stat->Reset(statParams);
+  // The levels are written to the cache while they are built
+  bool writeCache = !m_cacheDirectory.empty() && m_cache.create(m_cacheDirectory, m_image->params(), m_inputFormat, m_bands, m_levels.size(), nValues);
 
-  return stat;
-}
+  readBaseLevel();
+
+  if(writeCache)
+    m_cache.write(*m_levels[0]);
+
+  // No level will be built. So, the input image is scanned only to its statistics
+  if(m_levels.size() == 1)
+    accumulate(*m_levels[0], 0, 0, m_statistics[0]);
 
-void Pyramid::build()
-{
   TePDIPIManager progress("Building hierarchical pyramid", m_levels.size() - 1, m_progressEnabled);
 
   for(std::size_t i = 1; i < m_levels.size(); ++i)
   {
-    // Gets the previous level
-    TePDITypes::TePDIRasterPtrType previousLevel = m_levels[i - 1];
+    // The statistics of the input image are accumulated while the first level is built. The others, while they are written
+    buildLevel(i, i == 1 ? &m_statistics[0] : 0, &m_statistics[i]);
+
+    if(writeCache)
+      m_cache.write(*m_levels[i]);
+
+    // The previous levels are released if the budget is exceeded. They will be rebuilt on demand
+    releaseLevels(i);
+
+    progress.Update(i);
+  }
+
+  if(writeCache)
+  {
+    std::vector<double> values;
+    for(std::size_t i = 0; i < m_statistics.size(); ++i)
+      m_statistics[i].save(values);
+
+    m_cache.commit(values);
+  }
+
+  m_isBuilt = true;
+}
+
+bool Pyramid::openCache() const
+{
+  if(m_cacheDirectory.empty())
+    return false;
+
+  std::vector<std::size_t> nValues;
+  std::vector<TeRasterParams> params;
+
+  for(std::size_t i = 0; i < m_levels.size(); ++i)
+  {
+    params.push_back(getLevelParams(i));
+    nValues.push_back(static_cast<std::size_t>(params[i].nlines_) * params[i].ncols_ * params[i].nBands());
+  }
+
+  if(!m_cache.open(m_cacheDirectory, m_image->params(), m_inputFormat, m_bands, m_levels.size(), nValues))
+    return false;
+
+  const std::vector<double>& values = m_cache.getStatistics();
+  if(values.size() != m_levels.size() * m_bands.size() * 4)
+  {
+    m_cache.close();
+    return false;
+  }
+
+  const double* value = &values[0];
+  for(std::size_t i = 0; i < m_statistics.size(); ++i)
+    value = m_statistics[i].load(value, m_bands.size());
 
-    // Gets the previous bounding box
-    TeBox bbox = previousLevel->params().boundingBox();
+  // The levels are paged in when they are read
+  for(std::size_t i = 0; i < m_levels.size(); ++i)
+    m_levels[i]->attach(params[i], m_cache.getLevel(i));
+
+  return true;
+}
+
+TeRasterParams Pyramid::getLevelParams(const std::size_t& i) const
+{
+  // Only the considered bands. The double precision bands and the converted ones are stored on the configured precision
+  TeRasterParams params = m_image->params();
+  params.decoderIdentifier_ = "SMARTMEM";
+  params.mode_ = 'w';
+  params.nBands(static_cast<int>(m_bands.size()));
+
+  for(std::size_t b = 0; b < m_bands.size(); ++b)
+  {
+    assert(static_cast<int>(m_bands[b]) < m_image->params().nBands());
+
+    TeDataType dataType = m_image->params().dataType_[m_bands[b]];
+    params.setDataType(dataType == TeDOUBLE || m_inputFormat != Intensity ? MSEG_STORAGE_DATATYPE : dataType, static_cast<int>(b));
+  }
+
+  // Each level halves the resolution of the previous one
+  for(std::size_t k = 1; k <= i; ++k)
+  {
+    TeBox bbox = params.boundingBox();
 
-    // Adjust new level parameters
-    TeRasterParams params = previousLevel->params();
-    params.decoderIdentifier_ = "SMARTMEM";
-    params.mode_ = 'w';
     params.resolution_ = params.resolution_ * 2;
     params.boundingBoxResolution(bbox.x1_, bbox.y1_,bbox.x2_, bbox.y2_,
                                  params.resx_ * 2.0, params.resy_ * 2.0);
+  }
 
-    // Create the new level
-    TePDITypes::TePDIRasterPtrType newLevel(new TeRaster(params));
-    newLevel->init();
+  return params;
+}
 
-    build(previousLevel, newLevel);
+void Pyramid::readBaseLevel() const
+{
+  TeRasterParams params = getLevelParams(0);
 
-    // Store!
-    m_levels[i] = TePDITypes::TePDIRasterPtrType(newLevel);
+  PixelBuffer& level = *m_levels[0];
+  level.reset(params);
 
-    progress.Update(i);
+  const int nLines = params.nlines_;
+  const int nCols = params.ncols_;
+  const int nBands = params.nBands();
+
+  const std::size_t lineSize = static_cast<std::size_t>(nCols) * nBands;
+
+  // A block of lines for each thread
+  const int nBlockLines = sm_linesPerBlock * static_cast<int>(m_nThreads);
+
+  // The values of the lines of a block, as read
+  std::vector<double> values(static_cast<std::size_t>((std::min)(nBlockLines, nLines)) * lineSize);
+
+  for(int linStart = 0; linStart < nLines; linStart += nBlockLines)
+  {
+    const int linBound = (std::min)(linStart + nBlockLines, nLines);
+
+    // Reads the block. Note: by this thread only, the raster does not support concurrent reads
+    for(int lin = linStart; lin < linBound; ++lin)
+    {
+      double* line = &values[(lin - linStart) * lineSize];
+
+      for(int col = 0; col < nCols; ++col)
+      {
+        for(int b = 0; b < nBands; ++b)
+        {
+          bool valueWasRead = m_image->getElement(col, lin, line[col * nBands + b], m_bands[b]);
+          assert(valueWasRead);
+        }
+      }
+    }
+
+    // Converts the block
+#ifdef _OPENMP
+    #pragma omp parallel for num_threads(static_cast<int>(m_nThreads)) if(m_nThreads > 1)
+#endif
+    for(int lin = linStart; lin < linBound; ++lin)
+      convertLine(m_inputFormat, &values[(lin - linStart) * lineSize], lineSize, level.getLine(lin));
   }
 }
 
-void Pyramid::build(TePDITypes::TePDIRasterPtrType& previousLevel, TePDITypes::TePDIRasterPtrType& newLevel)
+void Pyramid::convertLine(const ImageFormat& format, const double* values, const std::size_t& n, PixelBuffer::Value* line)
 {
-  int nLines = newLevel->params().nlines_;
-  int nCols = newLevel->params().ncols_;
-  int nBands = newLevel->params().nBands();
+  // One loop for each format, without branches, so the compiler can vectorize them. Note: the conversions are computed in double precision
+  switch(format)
+  {
+    case Amplitude:
+      for(std::size_t i = 0; i < n; ++i)
+        line[i] = static_cast<PixelBuffer::Value>(values[i] * values[i]);
+    break;
+
+    case dB:
+      for(std::size_t i = 0; i < n; ++i)
+        line[i] = static_cast<PixelBuffer::Value>(std::pow(10.0, values[i] / 10.0));
+    break;
+
+    default:
+      for(std::size_t i = 0; i < n; ++i)
+        line[i] = static_cast<PixelBuffer::Value>(values[i]);
+  }
+}
 
-  double value = 0.0;
+void Pyramid::buildLevel(const std::size_t& i, Statistics* previousStatistics, Statistics* newStatistics) const
+{
+  assert(i > 0 && i < m_levels.size());
 
-  for(int lin = 0; lin < nLines; ++lin)
+  // Gets the previous level
+  const PixelBuffer& previousLevel = *m_levels[i - 1];
+  assert(!previousLevel.isEmpty());
+
+  // Create the new level
+  m_levels[i]->reset(getLevelParams(i));
+
+  build(previousLevel, *m_levels[i], previousStatistics, newStatistics);
+}
+
+void Pyramid::rebuildLevel(const std::size_t& i) const
+{
+  assert(i < m_levels.size());
+
+  // The levels of the cache are mapped again
+  if(m_cache.isOpen())
+  {
+    m_levels[i]->attach(getLevelParams(i), m_cache.getLevel(i));
+    return;
+  }
+
+  // The nearest finer level that is resident
+  std::size_t finer = i;
+  while(finer > 0 && m_levels[finer]->isEmpty())
+    --finer;
+
+  // None. So, the input image is read again
+  if(m_levels[finer]->isEmpty())
+    readBaseLevel();
+
+  // Streams the intermediate levels from it. They are released if the budget is exceeded
+  for(std::size_t k = finer + 1; k <= i; ++k)
+  {
+    buildLevel(k, 0, 0);
+    releaseLevels(k);
+  }
+}
+
+void Pyramid::releaseLevels(const std::size_t& keep) const
+{
+  if(m_memoryBudget == 0)
+    return;
+
+  // The finer levels are released first: the segmentation goes from the coarser to the finer ones
+  for(std::size_t i = 0; i < m_levels.size() && getResidentBytes() > m_memoryBudget; ++i)
   {
-    int linToRead = lin * 2;
-    for(int col = 0; col < nCols; ++col)
+    if(i != keep)
+      m_levels[i]->clear();
+  }
+}
+
+void Pyramid::build(const PixelBuffer& previousLevel, PixelBuffer& newLevel,
+                    Statistics* previousStatistics, Statistics* newStatistics) const
+{
+  const int nLines = static_cast<int>(newLevel.getNLines());
+  const int nCols = static_cast<int>(newLevel.getNCols());
+  const int nBands = static_cast<int>(newLevel.getNBands());
+
+  // The lines and columns of the previous level covered by the 2x2 windows
+  const int nReadLines = (std::min)(nLines * 2, static_cast<int>(previousLevel.getNLines()));
+  const int nReadCols = (std::min)(nCols * 2, static_cast<int>(previousLevel.getNCols()));
+
+  // The columns whose windows are inside the previous level. Note: the last column may have an odd window
+  const int nInteriorCols = nReadCols / 2;
+
+  assert(nReadLines > (nLines - 1) * 2);
+  assert(nReadCols > (nCols - 1) * 2);
+
+  const std::vector<TeDataType>& dataTypes = newLevel.getParams().dataType_;
+
+  const int nBlocks = (nLines + sm_linesPerBlock - 1) / sm_linesPerBlock;
+
+  // The statistics of each block
+  std::vector<Statistics> previousBlocks(previousStatistics ? nBlocks : 0);
+  std::vector<Statistics> newBlocks(newStatistics ? nBlocks : 0);
+
+  // Computes the averages and accumulates the statistics of each block, in the order of its pixels
+#ifdef _OPENMP
+  #pragma omp parallel for num_threads(static_cast<int>(m_nThreads)) if(m_nThreads > 1) schedule(dynamic)
+#endif
+  for(int block = 0; block < nBlocks; ++block)
+  {
+    Statistics* previousBlock = previousStatistics ? &previousBlocks[block] : 0;
+    Statistics* newBlock = newStatistics ? &newBlocks[block] : 0;
+
+    if(previousBlock)
+      previousBlock->reset(nBands);
+
+    if(newBlock)
+      newBlock->reset(nBands);
+
+    const int linBound = (std::min)((block + 1) * sm_linesPerBlock, nLines);
+
+    for(int lin = block * sm_linesPerBlock; lin < linBound; ++lin)
     {
-      int colToRead = col * 2;
+      const bool hasSecondLine = lin * 2 + 1 < nReadLines;
+
+      const PixelBuffer::Value* line0 = previousLevel.getLine(lin * 2);
+      const PixelBuffer::Value* line1 = hasSecondLine ? previousLevel.getLine(lin * 2 + 1) : line0;
+
+      PixelBuffer::Value* averages = newLevel.getLine(lin);
+
       for(int b = 0; b < nBands; ++b)
+        reduceLine(dataTypes[b], line0 + b, line1 + b, hasSecondLine, nInteriorCols, nCols, nBands, averages + b);
+
+      if(previousBlock == 0 && newBlock == 0)
+        continue;
+
+      for(int col = 0; col < nCols; ++col)
       {
-        double mean = 0.0;
-        std::size_t nPixels = 0;
+        const bool hasSecondCol = col * 2 + 1 < nReadCols;
 
-        if(previousLevel->getElement(colToRead, linToRead, value, b))
-        {
-          mean += value;
-          ++nPixels;
-        }
+        const std::size_t i = static_cast<std::size_t>(col) * 2 * nBands;
 
-        if(previousLevel->getElement(colToRead + 1, linToRead, value, b))
+        for(int b = 0; b < nBands; ++b)
         {
-          mean += value;
-          ++nPixels;
-        }
+          if(previousBlock)
+          {
+            previousBlock->add(b, line0[i + b]);
 
-        if(previousLevel->getElement(colToRead, linToRead + 1, value, b))
-        {
-          mean += value;
-          ++nPixels;
-        }
+            if(hasSecondCol)
+              previousBlock->add(b, line0[i + nBands + b]);
 
-        if(previousLevel->getElement(colToRead + 1, linToRead + 1, value, b))
-        {
-          mean += value;
-          ++nPixels;
-        }
+            if(hasSecondLine)
+            {
+              previousBlock->add(b, line1[i + b]);
 
-        assert(nPixels != 0);
+              if(hasSecondCol)
+                previousBlock->add(b, line1[i + nBands + b]);
+            }
+          }
 
-        newLevel->setElement(col, lin, mean / static_cast<double>(nPixels), b);
+          if(newBlock)
+            newBlock->add(b, averages[col * nBands + b]);
+        }
       }
     }
   }
+
+  // Combines the statistics of the blocks, in their order
+  for(int block = 0; block < nBlocks; ++block)
+  {
+    if(previousStatistics)
+      previousStatistics->combine(previousBlocks[block]);
+
+    if(newStatistics)
+      newStatistics->combine(newBlocks[block]);
+  }
+
+  // The pixels of the previous level that are not covered by the 2x2 windows
+  if(previousStatistics)
+    accumulate(previousLevel, nReadLines, nReadCols, *previousStatistics);
+}
+
+void Pyramid::reduceLine(const TeDataType& dataType, const PixelBuffer::Value* line0, const PixelBuffer::Value* line1, const bool& hasSecondLine,
+                         const int& nInteriorCols, const int& nCols, const int& stride, PixelBuffer::Value* averages)
+{
+  switch(dataType)
+  {
+    case TeBIT:
+    case TeUNSIGNEDCHAR:
+      reduceLine<unsigned char>(line0, line1, hasSecondLine, nInteriorCols, nCols, stride, averages);
+    break;
+
+    case TeCHAR:
+      reduceLine<signed char>(line0, line1, hasSecondLine, nInteriorCols, nCols, stride, averages);
+    break;
+
+    case TeUNSIGNEDSHORT:
+      reduceLine<unsigned short>(line0, line1, hasSecondLine, nInteriorCols, nCols, stride, averages);
+    break;
+
+    case TeSHORT:
+      reduceLine<short>(line0, line1, hasSecondLine, nInteriorCols, nCols, stride, averages);
+    break;
+
+    case TeINTEGER:
+    case TeLONG:
+      reduceLine<int>(line0, line1, hasSecondLine, nInteriorCols, nCols, stride, averages);
+    break;
+
+    case TeUNSIGNEDLONG:
+      reduceLine<unsigned int>(line0, line1, hasSecondLine, nInteriorCols, nCols, stride, averages);
+    break;
+
+    case TeFLOAT:
+      reduceLine<float>(line0, line1, hasSecondLine, nInteriorCols, nCols, stride, averages);
+    break;
+
+    default:
+      reduceLine<PixelBuffer::Value>(line0, line1, hasSecondLine, nInteriorCols, nCols, stride, averages);
+  }
+}
+
+void Pyramid::accumulate(const PixelBuffer& level, const int& linStart, const int& colStart, Statistics& statistics) const
+{
+  const int nLines = static_cast<int>(level.getNLines());
+  const int nCols = static_cast<int>(level.getNCols());
+  const int nBands = static_cast<int>(level.getNBands());
+
+  for(int lin = 0; lin < nLines; ++lin)
+  {
+    const PixelBuffer::Value* line = level.getLine(lin);
+
+    // Inside the window, only the columns from colStart
+    int col = lin < linStart ? colStart : 0;
+
+    for(; col < nCols; ++col)
+    {
+      for(int b = 0; b < nBands; ++b)
+        statistics.add(b, line[col * nBands + b]);
+    }
+  }
+}
+
+void Pyramid::Statistics::reset(const std::size_t& nBands)
+{
+  m_counts.assign(nBands, 0.0);
+  m_shifts.assign(nBands, 0.0);
+  m_sums.assign(nBands, 0.0);
+  m_squares.assign(nBands, 0.0);
+}
+
+void Pyramid::Statistics::add(const std::size_t& band, const double& value)
+{
+  assert(band < m_counts.size());
+
+  if(m_counts[band] == 0.0)
+    m_shifts[band] = value;
+
+  const double shifted = value - m_shifts[band];
+
+  m_counts[band] += 1.0;
+  m_sums[band] += shifted;
+  m_squares[band] += shifted * shifted;
+}
+
+double Pyramid::Statistics::getMean(const std::size_t& band) const
+{
+  assert(band < m_counts.size());
+
+  if(m_counts[band] == 0.0)
+    return 0.0;
+
+  return m_shifts[band] + m_sums[band] / m_counts[band];
+}
+
+double Pyramid::Statistics::getVariance(const std::size_t& band) const
+{
+  assert(band < m_counts.size());
+
+  if(m_counts[band] == 0.0)
+    return 0.0;
+
+  const double mean = m_sums[band] / m_counts[band];
+
+  return (std::max)(0.0, m_squares[band] / m_counts[band] - mean * mean);
+}
+
+void Pyramid::Statistics::combine(const Statistics& statistics)
+{
+  assert(statistics.m_counts.size() == m_counts.size());
+
+  for(std::size_t b = 0; b < m_counts.size(); ++b)
+  {
+    const double countB = statistics.m_counts[b];
+    if(countB == 0.0)
+      continue;
+
+    const double countA = m_counts[b];
+
+    // The first values: the given sums, as they are
+    if(countA == 0.0)
+    {
+      m_counts[b] = countB;
+      m_shifts[b] = statistics.m_shifts[b];
+      m_sums[b] = statistics.m_sums[b];
+      m_squares[b] = statistics.m_squares[b];
+      continue;
+    }
+
+    // The means, shifted by the shift of these statistics, and the sums of squared deviations of both
+    const double meanA = m_sums[b] / countA;
+    const double meanB = (statistics.m_shifts[b] - m_shifts[b]) + statistics.m_sums[b] / countB;
+
+    const double squaresA = m_squares[b] - m_sums[b] * meanA;
+    const double squaresB = statistics.m_squares[b] - statistics.m_sums[b] * statistics.m_sums[b] / countB;
+
+    const double count = countA + countB;
+    const double delta = meanB - meanA;
+
+    const double squares = squaresA + squaresB + delta * delta * countA * countB / count;
+
+    m_counts[b] = count;
+    m_sums[b] += meanB * countB;
+    m_squares[b] = squares + m_sums[b] * m_sums[b] / count;
+  }
+}
+
+void Pyramid::Statistics::save(std::vector<double>& values) const
+{
+  values.insert(values.end(), m_counts.begin(), m_counts.end());
+  values.insert(values.end(), m_shifts.begin(), m_shifts.end());
+  values.insert(values.end(), m_sums.begin(), m_sums.end());
+  values.insert(values.end(), m_squares.begin(), m_squares.end());
+}
+
+const double* Pyramid::Statistics::load(const double* values, const std::size_t& nBands)
+{
+  m_counts.assign(values, values + nBands);
+  m_shifts.assign(values + nBands, values + nBands * 2);
+  m_sums.assign(values + nBands * 2, values + nBands * 3);
+  m_squares.assign(values + nBands * 3, values + nBands * 4);
+
+  return values + nBands * 4;
 }
@@ -27,18 +27,35 @@
 
 // MultiSeg
 #include "Config.h"
+#include "Enums.h"
+#include "PixelBuffer.h"
+#include "PyramidCache.h"
 
 // TerraLib PDI
 #include <terralib/image_processing/TePDITypes.hpp>
-#include <terralib/image_processing/TePDIStatistic.hpp>
 
 // STL
+#include <string>
 #include <vector>
 
 /*!
   \class Pyramid
 
   \brief This class represents an image hierarchical pyramid.
+
+  The levels store only the considered bands of the input image, band-interleaved by pixel, on one buffer per level.
+  Level 0 is a copy of these bands of the input image. The data type of each band is kept on the coarser levels,
+  so the averages are stored as a raster of the input image data types would store them.
+
+  The values of a radar image in amplitude or dB are converted to intensity while they are read into level 0.
+  So, no converted copy of the input image is made, and the coarser levels are reduced from intensities.
+
+  The levels are built on demand: the first request of a level or of a statistic builds all levels in one pass.
+  With a memory budget, the levels that do not fit are released and rebuilt later, from the nearest finer level
+  that is resident or from the input image, when they are requested again.
+
+  With a cache directory, the levels and their statistics are written to a PyramidCache file when they are built.
+  The next pyramids of the same image file, bands and number of levels map that file instead of building the levels.
 */
 class MSEGEXPORT Pyramid
 {
@@ -47,7 +64,7 @@ class MSEGEXPORT Pyramid
     /*!
       \brief Constructor.
 
-      \param image            The input image.
+      \param image            The input image. All bands will be considered.
       \param nLevels          The pyramid number of levels.
       \param progressEnabled  A flag that indicates if the progress must be enabled.
     */
@@ -58,10 +75,13 @@ class MSEGEXPORT Pyramid
 
       \param image            The input image.
       \param nLevels          The pyramid number of levels.
-      \param bands            The input image bands that will be considered.
+      \param bands            The input image bands that will be considered. The levels store only these bands, in this order.
       \param progressEnabled  A flag that indicates if the progress must be enabled.
+      \param nThreads         The number of threads used to build the levels. It is effective only with OpenMP support.
+                              The input image must support concurrent reads.
     */
-    Pyramid(const TePDITypes::TePDIRasterPtrType& image, const std::size_t& nLevels, const std::vector<std::size_t>& bands, const bool& progressEnabled = false);
+    Pyramid(const TePDITypes::TePDIRasterPtrType& image, const std::size_t& nLevels, const std::vector<std::size_t>& bands,
+            const bool& progressEnabled = false, const std::size_t& nThreads = 1);
 
     /*! \brief Destructor. */
     ~Pyramid();
@@ -78,17 +98,54 @@ class MSEGEXPORT Pyramid
       
       \param i The requested level.
 
-      \return The i-th level of the hierarchical pyramid.
+      \return The i-th level of the hierarchical pyramid. The band b is the b-th considered band of the input image.
+
+      \note The level is built if it is not resident. The requested level is kept even if it exceeds the memory budget.
+             It is valid until the level is released.
     */
-    TePDITypes::TePDIRasterPtrType getLevel(const std::size_t& i) const;
+    const PixelBuffer& getLevel(const std::size_t& i) const;
 
     /*!
-      \brief This method releases the i-th level of the hierarchical pyramid.
+      \brief This method releases the i-th level of the hierarchical pyramid. It will be rebuilt if it is requested again.
       
       \param i The level that will be released.
     */
     void releaseLevel(const std::size_t& i);
 
+    /*!
+      \brief This method sets the maximum number of bytes of the levels held by the pyramid.
+
+      \param bytes The memory budget, in bytes. The default value is 0, that means no limit.
+
+      \note The finer levels are released first, since the segmentation goes from the coarser to the finer levels.
+    */
+    void setMemoryBudget(const std::size_t& bytes);
+
+    /*!
+      \brief This method returns the number of bytes of the levels held by the pyramid.
+
+      \return The resident bytes. The input image and the levels mapped from the cache are not considered.
+    */
+    std::size_t getResidentBytes() const;
+
+    /*!
+      \brief This method sets the directory of the pyramid cache files. See PyramidCache.
+
+      \param directory The directory. The default value is empty, that means no cache.
+
+      \note It must be set before the levels are built. The cache is used only if the input image is a file.
+    */
+    void setCacheDirectory(const std::string& directory);
+
+    /*!
+      \brief This method sets the format of the input image values. Amplitude and dB values are converted to intensity.
+
+      \param format The format of the input image values. The default value is Intensity, that means no conversion.
+
+      \note It must be set before the levels are built. The converted bands are stored on the configured precision.
+    */
+    void setInputFormat(const ImageFormat& format);
+
     /*!
       \brief Static method that resizes the given image based on the number of lines and columns.
       
@@ -112,27 +169,207 @@ class MSEGEXPORT Pyramid
     static TePDITypes::TePDIRasterPtrType resize(TePDITypes::TePDIRasterPtrType& labelledImage, TeRasterParams params);
 
     /*!
-      \brief This method computes the statistical values of the i-th level of the hierarchical pyramid.
-      
-      \param i The level that will be considered.
+      \brief This method returns the mean of a band of the i-th level of the hierarchical pyramid.
+
+      \param i    The level that will be considered.
+      \param band The band index. i.e. a position on the bands given to the constructor.
+
+      \return The mean of the band on the i-th level.
 
-      \return The statistical values of the i-th level of the hierarchical pyramid.
+      \note The statistics are accumulated while the pyramid is built. So, they are available even if the level was released.
     */
-    TePDIStatistic* buildStats(const std::size_t& i);
+    double getMean(const std::size_t& i, const std::size_t& band) const;
+
+    /*!
+      \brief This method returns the variance of a band of the i-th level of the hierarchical pyramid.
+
+      \param i    The level that will be considered.
+      \param band The band index. i.e. a position on the bands given to the constructor.
+
+      \return The (population) variance of the band on the i-th level.
+    */
+    double getVariance(const std::size_t& i, const std::size_t& band) const;
 
   private:
 
-    /*! \brief Internal method that builds the hierarchical pyramid. */
-    void build();
+    /*!
+      \struct Statistics
+
+      \brief The statistics of the bands of a level, accumulated pixel by pixel.
+
+      The sums are shifted by the first value of each band, so the variance does not suffer from cancellation.
+      The values are indexed by the band of the levels. i.e. a position on the considered bands.
+    */
+    struct Statistics
+    {
+      std::vector<double> m_counts;    //!< The number of pixels of each band.
+      std::vector<double> m_shifts;    //!< The first value of each band.
+      std::vector<double> m_sums;      //!< The sum of the shifted values of each band.
+      std::vector<double> m_squares;   //!< The sum of the squared shifted values of each band.
+
+      /*! \brief It clears the sums to the given number of bands. */
+      void reset(const std::size_t& nBands);
+
+      /*! \brief It adds a value of the given band. */
+      void add(const std::size_t& band, const double& value);
 
-    /*! \brief Internal method that builds the hierarchical pyramid. */
-    void build(TePDITypes::TePDIRasterPtrType& previousLevel, TePDITypes::TePDIRasterPtrType& newLevel);
+      /*! \brief It returns the mean of the given band. */
+      double getMean(const std::size_t& band) const;
+
+      /*! \brief It returns the (population) variance of the given band. */
+      double getVariance(const std::size_t& band) const;
+
+      /*! \brief It adds the values of the given statistics, of the same bands (Chan et al.). The shifts of these statistics are kept. */
+      void combine(const Statistics& statistics);
+
+      /*! \brief It appends the sums to the given values. */
+      void save(std::vector<double>& values) const;
+
+      /*! \brief It reads the sums of the given number of bands from the given values, as saved. It returns the next value. */
+      const double* load(const double* values, const std::size_t& nBands);
+    };
+
+    /*! \brief Internal method that builds all levels of the hierarchical pyramid and their statistics, or maps them from the cache. */
+    void build() const;
+
+    /*! \brief Internal method that maps the levels and reads the statistics from the cache, if it is valid. */
+    bool openCache() const;
+
+    /*! \brief Internal method that returns the raster parameters of the i-th level. */
+    TeRasterParams getLevelParams(const std::size_t& i) const;
+
+    /*!
+      \brief Internal method that reads the considered bands of the input image into the level 0.
+
+      The input image is read by a single thread, a block of lines at a time, since a raster can not be read concurrently.
+      The conversion of the lines of a block is shared among the threads.
+    */
+    void readBaseLevel() const;
+
+    /*!
+      \brief Internal method that builds the i-th level from the (i-1)-th one, that must be resident.
+
+      \param i                  The level that will be built.
+      \param previousStatistics If not null, all values of the previous level are added to it.
+      \param newStatistics      If not null, the values of the new level are added to it.
+    */
+    void buildLevel(const std::size_t& i, Statistics* previousStatistics, Statistics* newStatistics) const;
+
+    /*! \brief Internal method that rebuilds the i-th level from the nearest finer level that is resident, or from the input image. Or maps it from the cache. */
+    void rebuildLevel(const std::size_t& i) const;
+
+    /*! \brief Internal method that releases the levels, except the given one, until the memory budget is met. */
+    void releaseLevels(const std::size_t& keep) const;
+
+    /*!
+      \brief Internal method that builds a level of the hierarchical pyramid, through 2x2 averages of the previous one.
+
+      The blocks of sm_linesPerBlock lines of the new level are shared among the threads. The statistics of each block are
+      accumulated with its averages, and the blocks are combined in their order. So, the statistics do not depend on the number of threads.
+
+      \param previousLevel      The previous level.
+      \param newLevel           The level that will be built.
+      \param previousStatistics If not null, all values of the previous level are added to it.
+      \param newStatistics      If not null, the values of the new level, as stored, are added to it.
+    */
+    void build(const PixelBuffer& previousLevel, PixelBuffer& newLevel,
+               Statistics* previousStatistics, Statistics* newStatistics) const;
+
+    /*!
+      \brief Internal method that adds the values of a level, outside of the window [0, linStart) x [0, colStart), to its statistics.
+
+      \param level      The level.
+      \param linStart   The window number of lines.
+      \param colStart   The window number of columns.
+      \param statistics The statistics of the level.
+    */
+    void accumulate(const PixelBuffer& level, const int& linStart, const int& colStart, Statistics& statistics) const;
+
+    /*!
+      \brief Internal method that converts the values of a line of the input image to the stored values.
+
+      \param format The format of the input image values.
+      \param values The values read from the input image.
+      \param n      The number of values.
+      \param line   The stored values. Amplitude and dB values are converted to intensity.
+    */
+    static void convertLine(const ImageFormat& format, const double* values, const std::size_t& n, PixelBuffer::Value* line);
+
+    /*!
+      \brief Internal method that computes the 2x2 averages of a band over two lines of the previous level.
+
+      \param dataType      The data type of the band. The averages are stored as a raster of this data type would store them.
+      \param line0         The first value of the band on the first line.
+      \param line1         The first value of the band on the second line. It is line0 if there is no second line.
+      \param hasSecondLine A flag that indicates if there is a second line.
+      \param nInteriorCols The number of averages whose windows are inside the previous level.
+      \param nCols         The number of averages.
+      \param stride        The distance between two values of the band. i.e. the number of bands.
+      \param averages      The first value of the band on the new line.
+    */
+    static void reduceLine(const TeDataType& dataType, const PixelBuffer::Value* line0, const PixelBuffer::Value* line1, const bool& hasSecondLine,
+                           const int& nInteriorCols, const int& nCols, const int& stride, PixelBuffer::Value* averages);
+
+    /*! \brief Internal method that computes the 2x2 averages of a band, stored through the type T. \sa reduceLine */
+    template<class T> static void reduceLine(const PixelBuffer::Value* line0, const PixelBuffer::Value* line1, const bool& hasSecondLine,
+                                             const int& nInteriorCols, const int& nCols, const int& stride, PixelBuffer::Value* averages);
+
+    static const int sm_linesPerBlock; //!< The number of lines of the blocks shared among the threads.
+
+    /*! \brief No copy allowed. */
+    Pyramid(const Pyramid& rhs);
+
+    /*! \brief No copy allowed. */
+    Pyramid& operator=(const Pyramid& rhs);
 
   private:
 
-    std::vector<TePDITypes::TePDIRasterPtrType> m_levels; //!< The pyramid number of levels.
-    std::vector<std::size_t> m_bands;                     //!< The input image bands used to build the pyramid.
+    TePDITypes::TePDIRasterPtrType m_image;               //!< The input image.
+    mutable std::vector<PixelBuffer*> m_levels;           //!< The levels. A released or not built level is empty.
+    std::vector<std::size_t> m_bands;                     //!< The input image bands stored on the levels.
+    mutable std::vector<Statistics> m_statistics;         //!< The statistics of each level.
     bool m_progressEnabled;                               //!< A flag that indicates if the progress must be enabled.
+    std::size_t m_nThreads;                               //!< The number of threads used to build the levels.
+    std::size_t m_memoryBudget;                           //!< The maximum number of bytes of the levels held by the pyramid. 0 means no limit.
+    mutable bool m_isBuilt;                               //!< A flag that indicates if all levels were built once. i.e. if the statistics are available.
+    std::string m_cacheDirectory;                         //!< The directory of the pyramid cache files. Empty means no cache.
+    mutable PyramidCache m_cache;                         //!< The pyramid cache file. It is open while its levels are mapped.
+    ImageFormat m_inputFormat;                            //!< The format of the input image values.
 };
 
+template<class T> inline void Pyramid::reduceLine(const PixelBuffer::Value* line0, const PixelBuffer::Value* line1, const bool& hasSecondLine,
+                                                  const int& nInteriorCols, const int& nCols, const int& stride, PixelBuffer::Value* averages)
+{
+  const std::size_t step = static_cast<std::size_t>(stride);
+
+  // Interior: no bounds checks. Note: the sums are computed in double precision
+  if(hasSecondLine)
+  {
+    for(int col = 0; col < nInteriorCols; ++col)
+    {
+      const std::size_t i = col * 2 * step;
+      averages[col * step] = static_cast<PixelBuffer::Value>(static_cast<T>((((static_cast<double>(line0[i]) + line0[i + step]) + line1[i]) + line1[i + step]) / 4.0));
+    }
+  }
+  else
+  {
+    for(int col = 0; col < nInteriorCols; ++col)
+    {
+      const std::size_t i = col * 2 * step;
+      averages[col * step] = static_cast<PixelBuffer::Value>(static_cast<T>((static_cast<double>(line0[i]) + line0[i + step]) / 2.0));
+    }
+  }
+
+  // Odd right edge
+  if(nInteriorCols < nCols)
+  {
+    const std::size_t i = nInteriorCols * 2 * step;
+
+    if(hasSecondLine)
+      averages[nInteriorCols * step] = static_cast<PixelBuffer::Value>(static_cast<T>((static_cast<double>(line0[i]) + line1[i]) / 2.0));
+    else
+      averages[nInteriorCols * step] = line0[i];
+  }
+}
+
 #endif // __MULTISEG_INTERNAL_PYRAMID_H
@@ -0,0 +1,423 @@
+/*  Copyright (C) 2014 National Institute For Space Research (INPE) - Brazil.
+
+    MultiSeg is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    MultiSeg is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with MultiSeg. See COPYING.
+ */
+
+
+/*!
+  \file PyramidCache.cpp
+
+  \brief This class implements a persistent file of the hierarchical pyramid levels of an image.
+
+  \author Douglas Uba <douglas@dpi.inpe.br>
+*/
+
+// MultiSeg
+#include "PyramidCache.h"
+
+// Boost
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/lexical_cast.hpp>
+
+// STL
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+
+// System
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+const char PyramidCache::sm_magic[8] = { 'M', 'S', 'E', 'G', 'P', 'Y', 'R', '\0' };
+const boost::uint32_t PyramidCache::sm_version = 2;
+const std::size_t PyramidCache::sm_alignment = 4096;
+const std::size_t PyramidCache::sm_nHashBlocks = 16;
+const std::size_t PyramidCache::sm_hashBlockSize = 65536;
+
+PyramidCache::PyramidCache()
+  : m_file(0),
+    m_region(0),
+    m_nWrittenLevels(0)
+{
+  std::memset(&m_header, 0, sizeof(Header));
+}
+
+PyramidCache::~PyramidCache()
+{
+  close();
+}
+
+bool PyramidCache::open(const std::string& directory, const TeRasterParams& params, const ImageFormat& format,
+                        const std::vector<std::size_t>& bands, const std::size_t& nLevels, const std::vector<std::size_t>& nValues)
+{
+  close();
+
+  if(!initialize(directory, params, format, bands, nLevels, nValues))
+    return false;
+
+  std::ifstream input(m_path.c_str(), std::ios::binary);
+  if(!input)
+    return false;
+
+  // The header must match the expected one. i.e. the same image file and geometry, bands, levels and precision
+  Header header;
+  std::vector<boost::uint32_t> fileBands(m_bands.size());
+  std::vector<boost::uint64_t> fileOffsets(m_offsets.size());
+
+  input.read(reinterpret_cast<char*>(&header), sizeof(Header));
+  if(!input || std::memcmp(header.m_magic, m_header.m_magic, sizeof(header.m_magic)) != 0 ||
+     header.m_version != m_header.m_version || header.m_valueSize != m_header.m_valueSize ||
+     header.m_sourceSize != m_header.m_sourceSize || header.m_sourceTime != m_header.m_sourceTime ||
+     header.m_sourceHash != m_header.m_sourceHash || header.m_nLevels != m_header.m_nLevels || header.m_nBands != m_header.m_nBands ||
+     header.m_nLines != m_header.m_nLines || header.m_nCols != m_header.m_nCols ||
+     std::memcmp(header.m_boundingBox, m_header.m_boundingBox, sizeof(header.m_boundingBox)) != 0)
+    return false;
+
+  input.read(reinterpret_cast<char*>(&fileBands[0]), fileBands.size() * sizeof(boost::uint32_t));
+  input.read(reinterpret_cast<char*>(&fileOffsets[0]), fileOffsets.size() * sizeof(boost::uint64_t));
+  if(!input || fileBands != m_bands || fileOffsets != m_offsets)
+    return false;
+
+  // The file must be complete
+  const boost::uint64_t size = m_offsets.back() + header.m_nStatistics * sizeof(double);
+
+  input.seekg(0, std::ios::end);
+  if(!input || static_cast<boost::uint64_t>(input.tellg()) != size)
+    return false;
+
+  m_statistics.resize(static_cast<std::size_t>(header.m_nStatistics));
+
+  input.seekg(static_cast<std::streamoff>(m_offsets.back()));
+  if(!m_statistics.empty())
+    input.read(reinterpret_cast<char*>(&m_statistics[0]), m_statistics.size() * sizeof(double));
+  if(!input)
+    return false;
+
+  input.close();
+
+  m_header = header;
+
+  // Maps the whole file. The pages are read only when they are accessed. The writes are private
+  try
+  {
+    m_file = new boost::interprocess::file_mapping(m_path.c_str(), boost::interprocess::read_only);
+    m_region = new boost::interprocess::mapped_region(*m_file, boost::interprocess::copy_on_write);
+  }
+  catch(const boost::interprocess::interprocess_exception&)
+  {
+    close();
+    return false;
+  }
+
+  return true;
+}
+
+bool PyramidCache::isOpen() const
+{
+  return m_region != 0;
+}
+
+PixelBuffer::Value* PyramidCache::getLevel(const std::size_t& i) const
+{
+  assert(isOpen());
+  assert(i + 1 < m_offsets.size());
+
+  return reinterpret_cast<PixelBuffer::Value*>(static_cast<char*>(m_region->get_address()) + m_offsets[i]);
+}
+
+const std::vector<double>& PyramidCache::getStatistics() const
+{
+  return m_statistics;
+}
+
+bool PyramidCache::create(const std::string& directory, const TeRasterParams& params, const ImageFormat& format,
+                          const std::vector<std::size_t>& bands, const std::size_t& nLevels, const std::vector<std::size_t>& nValues)
+{
+  close();
+
+  if(!initialize(directory, params, format, bands, nLevels, nValues))
+    return false;
+
+  // Each writer has its own temporary file. i.e. the concurrent segmentations of the same image do not share it
+  m_temporaryPath = getTemporaryPath();
+
+  m_output.open(m_temporaryPath.c_str(), std::ios::binary | std::ios::trunc);
+  if(!m_output)
+    return false;
+
+  // The header is written again, with the number of statistics, when the file is committed
+  m_output.write(reinterpret_cast<const char*>(&m_header), sizeof(Header));
+  m_output.write(reinterpret_cast<const char*>(&m_bands[0]), m_bands.size() * sizeof(boost::uint32_t));
+  m_output.write(reinterpret_cast<const char*>(&m_offsets[0]), m_offsets.size() * sizeof(boost::uint64_t));
+
+  if(!m_output)
+  {
+    close();
+    return false;
+  }
+
+  return true;
+}
+
+bool PyramidCache::write(const PixelBuffer& level)
+{
+  if(!m_output.is_open())
+    return false;
+
+  assert(m_nWrittenLevels + 1 < m_offsets.size());
+  assert(level.getNLines() * level.getNCols() * level.getNBands() * sizeof(PixelBuffer::Value) <= m_offsets[m_nWrittenLevels + 1] - m_offsets[m_nWrittenLevels]);
+
+  // Padding
+  const std::streamoff start = static_cast<std::streamoff>(m_offsets[m_nWrittenLevels]);
+  while(m_output && m_output.tellp() < start)
+    m_output.put('\0');
+
+  const std::size_t lineSize = level.getNCols() * level.getNBands() * sizeof(PixelBuffer::Value);
+
+  for(std::size_t lin = 0; lin < level.getNLines() && m_output; ++lin)
+    m_output.write(reinterpret_cast<const char*>(level.getLine(lin)), lineSize);
+
+  if(!m_output)
+  {
+    close();
+    return false;
+  }
+
+  ++m_nWrittenLevels;
+
+  return true;
+}
+
+bool PyramidCache::commit(const std::vector<double>& statistics)
+{
+  if(!m_output.is_open() || m_nWrittenLevels + 1 != m_offsets.size())
+  {
+    close();
+    return false;
+  }
+
+  // Padding
+  const std::streamoff start = static_cast<std::streamoff>(m_offsets.back());
+  while(m_output && m_output.tellp() < start)
+    m_output.put('\0');
+
+  if(!statistics.empty())
+    m_output.write(reinterpret_cast<const char*>(&statistics[0]), statistics.size() * sizeof(double));
+
+  m_header.m_nStatistics = statistics.size();
+
+  m_output.seekp(0);
+  m_output.write(reinterpret_cast<const char*>(&m_header), sizeof(Header));
+  m_output.close();
+
+  if(!m_output)
+  {
+    close();
+    return false;
+  }
+
+  // Replaces the previous file
+  std::remove(m_path.c_str());
+  bool renamed = std::rename(m_temporaryPath.c_str(), m_path.c_str()) == 0;
+
+  m_nWrittenLevels = 0;
+
+  if(!renamed)
+    std::remove(m_temporaryPath.c_str());
+
+  return renamed;
+}
+
+void PyramidCache::close()
+{
+  delete m_region;
+  m_region = 0;
+
+  delete m_file;
+  m_file = 0;
+
+  m_statistics.clear();
+
+  // Discards an uncommitted file
+  if(m_output.is_open())
+  {
+    m_output.close();
+    std::remove(m_temporaryPath.c_str());
+  }
+
+  m_output.clear();
+  m_nWrittenLevels = 0;
+}
+
+bool PyramidCache::IsFileBacked(const TeRasterParams& params)
+{
+  // The memory and database decoders. Their file name, if any, does not hold the values
+  const std::string& decoder = params.decoderIdentifier_;
+  if(decoder == "MEM" || decoder == "SMARTMEM" || decoder == "MEMMAP" || decoder == "DB")
+    return false;
+
+  if(params.fileName_.empty())
+    return false;
+
+#ifdef WIN32
+  struct _stat64 info;
+  if(_stat64(params.fileName_.c_str(), &info) != 0)
+    return false;
+#else
+  struct stat info;
+  if(stat(params.fileName_.c_str(), &info) != 0)
+    return false;
+#endif
+
+  return (info.st_mode & S_IFMT) == S_IFREG;
+}
+
+bool PyramidCache::initialize(const std::string& directory, const TeRasterParams& params, const ImageFormat& format,
+                              const std::vector<std::size_t>& bands, const std::size_t& nLevels, const std::vector<std::size_t>& nValues)
+{
+  assert(nValues.size() == nLevels);
+
+  if(directory.empty() || bands.empty() || nLevels == 0 || !IsFileBacked(params))
+    return false;
+
+  const std::string& fileName = params.fileName_;
+
+  std::memset(&m_header, 0, sizeof(Header));
+  std::memcpy(m_header.m_magic, sm_magic, sizeof(sm_magic));
+  m_header.m_version = sm_version;
+  m_header.m_valueSize = sizeof(PixelBuffer::Value);
+  m_header.m_nLevels = static_cast<boost::uint32_t>(nLevels);
+  m_header.m_nBands = static_cast<boost::uint32_t>(bands.size());
+  m_header.m_nLines = static_cast<boost::uint64_t>(params.nlines_);
+  m_header.m_nCols = static_cast<boost::uint64_t>(params.ncols_);
+
+  const TeBox box = params.boundingBox();
+  m_header.m_boundingBox[0] = box.x1_;
+  m_header.m_boundingBox[1] = box.y1_;
+  m_header.m_boundingBox[2] = box.x2_;
+  m_header.m_boundingBox[3] = box.y2_;
+
+  if(!Fingerprint(fileName, m_header.m_sourceSize, m_header.m_sourceTime, m_header.m_sourceHash))
+    return false;
+
+  // Path: <directory>/<image file base name>[_amplitude | _db]_b<bands>_l<levels>_f<value bits>.mpc
+  std::string::size_type slash = fileName.find_last_of("/\\");
+  m_path = directory + "/" + (slash == std::string::npos ? fileName : fileName.substr(slash + 1));
+
+  // The converted levels are not the levels of the image values
+  if(format == Amplitude)
+    m_path += "_amplitude";
+  else if(format == dB)
+    m_path += "_db";
+
+  m_path += "_b";
+
+  m_bands.resize(bands.size());
+  for(std::size_t b = 0; b < bands.size(); ++b)
+  {
+    m_bands[b] = static_cast<boost::uint32_t>(bands[b]);
+    m_path += (b ? "-" : "") + boost::lexical_cast<std::string>(bands[b]);
+  }
+
+  m_path += "_l" + boost::lexical_cast<std::string>(nLevels) + "_f" + boost::lexical_cast<std::string>(sizeof(PixelBuffer::Value) * 8) + ".mpc";
+
+  // The levels start after the header, the bands and the offsets. The statistics, after the levels
+  m_offsets.resize(nLevels + 1);
+  m_offsets[0] = Align(sizeof(Header) + m_bands.size() * sizeof(boost::uint32_t) + m_offsets.size() * sizeof(boost::uint64_t));
+
+  for(std::size_t i = 0; i < nLevels; ++i)
+    m_offsets[i + 1] = Align(m_offsets[i] + static_cast<boost::uint64_t>(nValues[i]) * sizeof(PixelBuffer::Value));
+
+  return true;
+}
+
+bool PyramidCache::Fingerprint(const std::string& fileName, boost::uint64_t& size, boost::int64_t& time, boost::uint64_t& hash)
+{
+#ifdef WIN32
+  struct _stat64 info;
+  if(_stat64(fileName.c_str(), &info) != 0)
+    return false;
+#else
+  struct stat info;
+  if(stat(fileName.c_str(), &info) != 0)
+    return false;
+#endif
+
+  size = static_cast<boost::uint64_t>(info.st_size);
+  time = static_cast<boost::int64_t>(info.st_mtime);
+
+  std::ifstream input(fileName.c_str(), std::ios::binary);
+  if(!input)
+    return false;
+
+  // FNV-1a over evenly spaced blocks. Small files are hashed entirely
+  hash = 14695981039346656037ULL;
+
+  const boost::uint64_t nBlocks = size > sm_nHashBlocks * sm_hashBlockSize ? sm_nHashBlocks : 1;
+  const boost::uint64_t blockSize = nBlocks > 1 ? sm_hashBlockSize : size;
+
+  std::vector<char> block(static_cast<std::size_t>(blockSize));
+
+  for(boost::uint64_t i = 0; i < nBlocks && blockSize > 0; ++i)
+  {
+    // The first block is at the beginning of the file and the last one at the end
+    const boost::uint64_t offset = nBlocks > 1 ? (size - blockSize) / (nBlocks - 1) * i : 0;
+
+    input.seekg(static_cast<std::streamoff>(offset));
+    input.read(&block[0], static_cast<std::streamsize>(blockSize));
+    if(!input)
+      return false;
+
+    for(std::size_t j = 0; j < block.size(); ++j)
+    {
+      hash ^= static_cast<unsigned char>(block[j]);
+      hash *= 1099511628211ULL;
+    }
+  }
+
+  return true;
+}
+
+std::string PyramidCache::getTemporaryPath() const
+{
+  static std::size_t counter = 0;
+
+  std::size_t n;
+
+#ifdef _OPENMP
+  #pragma omp critical(PyramidCacheTemporaryPath)
+#endif
+  n = counter++;
+
+#ifdef WIN32
+  const int pid = _getpid();
+#else
+  const int pid = static_cast<int>(getpid());
+#endif
+
+  // On the same directory, so the committed file is renamed, not copied
+  return m_path + "." + boost::lexical_cast<std::string>(pid) + "-" + boost::lexical_cast<std::string>(n) + ".tmp";
+}
+
+boost::uint64_t PyramidCache::Align(const boost::uint64_t& offset)
+{
+  return (offset + sm_alignment - 1) / sm_alignment * sm_alignment;
+}
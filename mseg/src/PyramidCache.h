@@ -0,0 +1,229 @@
+/*  Copyright (C) 2014 National Institute For Space Research (INPE) - Brazil.
+
+    MultiSeg is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    MultiSeg is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with MultiSeg. See COPYING.
+ */
+
+
+/*!
+  \file PyramidCache.h
+
+  \brief This class implements a persistent file of the hierarchical pyramid levels of an image.
+
+  \author Douglas Uba <douglas@dpi.inpe.br>
+*/
+
+#ifndef __MULTISEG_INTERNAL_PYRAMIDCACHE_H
+#define __MULTISEG_INTERNAL_PYRAMIDCACHE_H
+
+// MultiSeg
+#include "Config.h"
+#include "Enums.h"
+#include "PixelBuffer.h"
+
+// Boost
+#include <boost/cstdint.hpp>
+
+// STL
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Forward declarations
+namespace boost { namespace interprocess { class file_mapping; class mapped_region; } }
+
+/*!
+  \class PyramidCache
+
+  \brief This class implements a persistent file of the hierarchical pyramid levels of an image.
+
+  There is one file for each image file, format of its values, set of bands, number of levels and storage precision. It holds a header,
+  the values of each level (as stored on PixelBuffer), aligned to pages, and the statistics of the levels.
+  The file is mapped on memory (copy-on-write). So, the levels are paged in only when they are read.
+
+  The file records the size, the modification time and a content hash of the image file, and the geometry of the raster
+  (lines, columns and bounding box). It is used only if they still match. The content hash is computed over sm_nHashBlocks
+  blocks, evenly spaced, of the image file. Only the rasters read from a file are cached. See IsFileBacked().
+
+  \note The files are written on the native byte order.
+
+  \note Each level is stored contiguously, line by line, as on PixelBuffer. i.e. it is not tiled. So, a window of a level
+        pages in whole lines, and a level is read efficiently only by lines.
+*/
+class MSEGEXPORT PyramidCache
+{
+  public:
+
+    /*! \brief Default constructor. */
+    PyramidCache();
+
+    /*! \brief Destructor. */
+    ~PyramidCache();
+
+    /*!
+      \brief This method maps the file of the given pyramid, if it exists and it is still valid.
+
+      \param directory The directory of the files.
+      \param params    The raster parameters of the image. i.e. its file name and geometry.
+      \param format    The format of the image values. The levels of a converted image are stored on their own file.
+      \param bands     The image bands stored on the levels.
+      \param nLevels   The number of levels, including the level 0.
+      \param nValues   The number of values of each level. i.e. lines * columns * bands.
+
+      \return It returns true if the file was mapped and false otherwise.
+    */
+    bool open(const std::string& directory, const TeRasterParams& params, const ImageFormat& format,
+              const std::vector<std::size_t>& bands, const std::size_t& nLevels, const std::vector<std::size_t>& nValues);
+
+    /*!
+      \brief This method returns if a file is mapped.
+
+      \return It returns true if a file is mapped and false otherwise.
+    */
+    bool isOpen() const;
+
+    /*!
+      \brief This method returns the values of a level of the mapped file.
+
+      \param i The level.
+
+      \return The values of the level, line by line and pixel by pixel.
+    */
+    PixelBuffer::Value* getLevel(const std::size_t& i) const;
+
+    /*!
+      \brief This method returns the statistics of the levels of the mapped file.
+
+      \return The values given to commit().
+    */
+    const std::vector<double>& getStatistics() const;
+
+    /*!
+      \brief This method starts to write the file of the given pyramid. The levels must be written in order, and then committed.
+
+      \param directory The directory of the files.
+      \param params    The raster parameters of the image. i.e. its file name and geometry.
+      \param format    The format of the image values. The levels of a converted image are stored on their own file.
+      \param bands     The image bands stored on the levels.
+      \param nLevels   The number of levels, including the level 0.
+      \param nValues   The number of values of each level. i.e. lines * columns * bands.
+
+      \return It returns true if the file can be written and false otherwise.
+
+      \note The values are written to a temporary file, with a unique name on the directory. It replaces the previous file only when committed.
+    */
+    bool create(const std::string& directory, const TeRasterParams& params, const ImageFormat& format,
+                const std::vector<std::size_t>& bands, const std::size_t& nLevels, const std::vector<std::size_t>& nValues);
+
+    /*!
+      \brief This method writes the next level.
+
+      \param level The level.
+
+      \return It returns true if the level was written and false otherwise.
+    */
+    bool write(const PixelBuffer& level);
+
+    /*!
+      \brief This method writes the statistics of the levels and makes the file available.
+
+      \param statistics The statistics of the levels.
+
+      \return It returns true if the file was written and false otherwise.
+    */
+    bool commit(const std::vector<double>& statistics);
+
+    /*! \brief This method unmaps the file, or discards the file being written. */
+    void close();
+
+    /*!
+      \brief This method returns if the given raster is read from a file. i.e. if its pyramid can be cached.
+
+      \param params The raster parameters.
+
+      \return It returns true if the raster decoder is not a memory or database one, and its file name is a regular file. False otherwise.
+    */
+    static bool IsFileBacked(const TeRasterParams& params);
+
+  private:
+
+    /*!
+      \struct Header
+
+      \brief The fixed part of the header of a file. It is followed by the bands, by the offset of each level and by the statistics.
+    */
+    struct Header
+    {
+      char m_magic[8];                 //!< The file signature.
+      boost::uint32_t m_version;       //!< The file format version.
+      boost::uint32_t m_valueSize;     //!< The size of a stored value. i.e. sizeof(PixelBuffer::Value).
+      boost::uint64_t m_sourceSize;    //!< The size of the image file.
+      boost::int64_t m_sourceTime;     //!< The modification time of the image file.
+      boost::uint64_t m_sourceHash;    //!< The content hash of the image file.
+      boost::uint32_t m_nLevels;       //!< The number of levels.
+      boost::uint32_t m_nBands;        //!< The number of bands.
+      boost::uint64_t m_nLines;        //!< The number of lines of the image.
+      boost::uint64_t m_nCols;         //!< The number of columns of the image.
+      double m_boundingBox[4];         //!< The bounding box of the image: x1, y1, x2 and y2.
+      boost::uint64_t m_nStatistics;   //!< The number of statistics values.
+    };
+
+    /*!
+      \brief Internal method that computes the path, the header and the level offsets of a pyramid.
+
+      \return It returns true if the image file can be fingerprinted and false otherwise.
+    */
+    bool initialize(const std::string& directory, const TeRasterParams& params, const ImageFormat& format,
+                    const std::vector<std::size_t>& bands, const std::size_t& nLevels, const std::vector<std::size_t>& nValues);
+
+    /*!
+      \brief Internal method that computes the size, the modification time and the content hash of a file.
+
+      \return It returns true if the file was read and false otherwise.
+    */
+    static bool Fingerprint(const std::string& fileName, boost::uint64_t& size, boost::int64_t& time, boost::uint64_t& hash);
+
+    /*! \brief Internal method that returns a temporary file name, unique on the process and among the processes. */
+    std::string getTemporaryPath() const;
+
+    /*! \brief Internal method that rounds up the given offset to the alignment of the levels. */
+    static boost::uint64_t Align(const boost::uint64_t& offset);
+
+    /*! \brief No copy allowed. */
+    PyramidCache(const PyramidCache& rhs);
+
+    /*! \brief No copy allowed. */
+    PyramidCache& operator=(const PyramidCache& rhs);
+
+  private:
+
+    static const char sm_magic[8];                 //!< The file signature.
+    static const boost::uint32_t sm_version;       //!< The file format version.
+    static const std::size_t sm_alignment;         //!< The alignment of the levels on the file, in bytes.
+    static const std::size_t sm_nHashBlocks;       //!< The number of blocks of the image file considered by the content hash.
+    static const std::size_t sm_hashBlockSize;     //!< The size of each block considered by the content hash, in bytes.
+
+    std::string m_path;                            //!< The path of the file.
+    std::string m_temporaryPath;                   //!< The path of the file being written. It is renamed to m_path when committed.
+    Header m_header;                               //!< The header of the file.
+    std::vector<boost::uint32_t> m_bands;          //!< The bands stored on the levels.
+    std::vector<boost::uint64_t> m_offsets;        //!< The offset of each level on the file, and the offset of the statistics.
+    std::vector<double> m_statistics;              //!< The statistics of the levels.
+    boost::interprocess::file_mapping* m_file;     //!< The mapped file.
+    boost::interprocess::mapped_region* m_region;  //!< The mapped region. i.e. the whole file.
+    std::ofstream m_output;                        //!< The file being written.
+    std::size_t m_nWrittenLevels;                  //!< The number of levels written to m_output.
+};
+
+#endif // __MULTISEG_INTERNAL_PYRAMIDCACHE_H
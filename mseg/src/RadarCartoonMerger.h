@@ -29,6 +29,10 @@
 #include "Config.h"
 #include "EuclideanMerger.h"
 
+// STL
+#include <cassert>
+#include <cmath>
+
 /*!
   \class RadarCartoonMerger
 
@@ -46,11 +50,105 @@ class MSEGEXPORT RadarCartoonMerger : public EuclideanMerger
     /*! \brief Destructor. */
     ~RadarCartoonMerger();
 
+    bool predicate(Region* r1, Region* r2) const;
+
+    double getDissimilarity(const std::vector<double>& p, Region* r) const;
+
+    std::size_t predicates(Region* region, const std::vector<Region*>& regions,
+                           std::vector<unsigned char>& passes, std::vector<double>& distances) const;
+
   protected:
 
     bool predicate(Region* r1, Region* r2, const std::size_t& band) const;
 
     double getDissimilarity(const std::vector<double>& p, Region* r, const std::size_t& band) const;
+
+  friend class AbstractMerger;
 };
 
+inline bool RadarCartoonMerger::predicate(Region* r1, Region* r2, const std::size_t& band) const
+{
+  assert(r1);
+  assert(r2);
+  assert(r1->getNBands() ==  r2->getNBands());
+
+  // pixel vs. pixel or pixel vs. region
+  if(r1->getSize() == 1)
+    return EuclideanMerger::predicate(r1, r2, band);
+
+  // Gets the regions mean
+  const Region::Statistic* mean1 = r1->getMean();
+  const Region::Statistic* mean2 = r2->getMean();
+
+  assert(band < r1->getNBands());
+
+  // region vs. pixel
+  if(r1->getSize() > 1 && r2->getSize() == 1)
+  {
+    // Gets the pre-computed vcritic factor
+    double vcriticFactor = m_paramBlock.m_vcriticFactor;
+
+    // r1 is the region
+    double regionMean = mean1[band];
+
+    // r2 is the pixel
+    double pixelValue = mean2[band];
+
+    // Computes the vcritic
+    double vcritic =  vcriticFactor * regionMean;
+
+    if(pixelValue > vcritic)
+      return false;
+    else
+      return true;
+  }
+
+  // region vs. region
+  assert(r1->getSize() > 1 && r2->getSize() > 1);
+
+  // Gets the current ENL
+  double enl = m_paramBlock.m_enl;
+
+  // Gets the mean A
+  double meanA = mean1[band];
+
+  // Gets the mean B
+  double meanB = mean2[band];
+
+  // Computes the variance A and B (estimate)
+  double varianceA = (meanA * meanA) / enl;
+  double varianceB = (meanB * meanB) / enl;
+
+  // Degrees of Freedom (t-Student)
+  double dof = r1->getSize() + r2->getSize() - 2.0;
+
+  double rootVarianceAB = sqrt(((((r1->getSize() - 1) * varianceA) + ((r2->getSize() - 1) * varianceB)) / (dof))
+                               * ((1.0 / static_cast<double>(r1->getSize())) + (1.0 / static_cast<double>(r2->getSize()))));
+
+  assert(rootVarianceAB != 0.0);
+
+  double tValue = std::abs(meanA - meanB) / rootVarianceAB;
+
+  // p = 1 - cdf(tValue) >= 1 - confidence_level. i.e. tValue is not greater than the critical value
+  if(tValue <= m_paramBlock.m_criticalValues.getT(r1->getSize() + r2->getSize() - 2))
+    return true;
+  else
+    return false;
+}
+
+inline double RadarCartoonMerger::getDissimilarity(const std::vector<double>& p, Region* r, const std::size_t& band) const
+{
+  // Gets the region mean
+  const Region::Statistic* mean = r->getMean();
+  assert(band < r->getNBands());
+
+  // Gets the squared euclidean distance between the pixel and the region
+  double distance = EuclideanMerger::getDissimilarity(p, r, band);
+
+  // Uses the pre-computed root of the current ENL
+  double n = mean[band] / m_paramBlock.m_rootENL;
+
+  return distance / n;
+}
+
 #endif // __MULTISEG_INTERNAL_RADARCARTOONMERGER_H
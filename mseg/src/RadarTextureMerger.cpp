@@ -0,0 +1,90 @@
+/*  Copyright (C) 2014 National Institute For Space Research (INPE) - Brazil.
+
+    MultiSeg is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    MultiSeg is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with MultiSeg. See COPYING.
+ */
+
+
+/*!
+  \file RadarTextureMerger.cpp
+
+  \brief This class implements the merger to radar texture images.
+
+  \author Douglas Uba <douglas@dpi.inpe.br>
+*/
+
+// MultiSeg
+#include "RadarTextureMerger.h"
+#include "Region.h"
+
+// STL
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+RadarTextureMerger::RadarTextureMerger()
+  : TextureMerger()
+{
+}
+
+RadarTextureMerger::~RadarTextureMerger()
+{
+}
+
+bool RadarTextureMerger::usesHigherMoments() const
+{
+  return true;
+}
+
+bool RadarTextureMerger::compareTexture(Region* r1, Region* r2, const std::size_t& band) const
+{
+  // Gets the coefficients of variation
+  double cvA = r1->getCV()[band];
+  double cvB = r2->getCV()[band];
+
+  double rootVarianceAB = sqrt(getCVVariance(r1, band) + getCVVariance(r2, band));
+
+  // Two regions without texture
+  if(rootVarianceAB == 0.0)
+    return cvA == cvB;
+
+  double zValue = std::abs(cvA - cvB) / rootVarianceAB;
+
+  // p = 1 - cdf(zValue) >= 1 - confidence_level. i.e. zValue is not greater than the critical value
+  if(zValue <= m_paramBlock.m_criticalValues.getZ())
+    return true;
+  else
+    return false;
+}
+
+double RadarTextureMerger::getCVVariance(Region* r, const std::size_t& band)
+{
+  assert(r);
+  assert(band < r->getNBands());
+
+  double cv = r->getCV()[band];
+  double n = static_cast<double>(r->getSize());
+
+  double variance = r->getVariance()[band];
+
+  // Normal approximation (McKay) if the moments are not tracked or the region has no texture
+  if(r->getThirdMoment() == 0 || r->getFourthMoment() == 0 || variance <= 0.0)
+    return (cv * cv * (0.5 + cv * cv)) / n;
+
+  // Skewness and kurtosis of the region
+  double skewness = r->getThirdMoment()[band] / (variance * sqrt(variance));
+  double kurtosis = r->getFourthMoment()[band] / (variance * variance);
+
+  // Delta method: c^2 / n * (c^2 - skewness * c + (kurtosis - 1) / 4). It is McKay for normal values
+  return std::max(0.0, (cv * cv * (cv * cv - skewness * cv + (kurtosis - 1.0) / 4.0)) / n);
+}
@@ -0,0 +1,70 @@
+/*  Copyright (C) 2014 National Institute For Space Research (INPE) - Brazil.
+
+    MultiSeg is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    MultiSeg is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with MultiSeg. See COPYING.
+ */
+
+/*!
+  \file RadarTextureMerger.h
+
+  \brief This class implements the merger to radar texture images.
+
+  \author Douglas Uba <douglas@dpi.inpe.br>
+*/
+
+#ifndef __MULTISEG_INTERNAL_RADARTEXTUREMERGER_H
+#define __MULTISEG_INTERNAL_RADARTEXTUREMERGER_H
+
+// MutiSeg
+#include "Config.h"
+#include "TextureMerger.h"
+
+/*!
+  \class RadarTextureMerger
+
+  \brief This class implements the merger to radar texture images.
+
+  The texture of a region is described by the coefficient of variation of each band. Under the
+  multiplicative model (e.g. gamma or K distributed intensities), it is the normalized second moment
+  that drives the texture estimates and it is independent of the region mean.
+
+  Two regions are homogeneous if their coefficients of variation are not significantly different.
+  The variance of each coefficient is estimated from the skewness and kurtosis of the region (delta method),
+  so the test holds for the heavy tailed distributions of the textured regions. The third and fourth central
+  moments are mergeable statistics, so a merge is O(bands).
+
+  \sa AbstractMerger, TextureMerger, RadarCartoonMerger, CompositeMerger
+*/
+class MSEGEXPORT RadarTextureMerger : public TextureMerger
+{
+  public:
+
+    /*! \brief Default constructor. */
+    RadarTextureMerger();
+
+    /*! \brief Destructor. */
+    ~RadarTextureMerger();
+
+    bool usesHigherMoments() const;
+
+  protected:
+
+    bool compareTexture(Region* r1, Region* r2, const std::size_t& band) const;
+
+  private:
+
+    /*! \brief This method computes the variance of the coefficient of variation of a region considering a specific band. */
+    static double getCVVariance(Region* r, const std::size_t& band);
+};
+
+#endif // __MULTISEG_INTERNAL_RADARTEXTUREMERGER_H
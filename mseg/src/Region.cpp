@@ -27,21 +27,51 @@
 
 // STL
 #include <algorithm>
+#include <cassert>
 #include <iostream>
 #include <cmath>
 
 Region::Region(const std::size_t& id, const std::vector<double>& pixel,
-               const std::size_t& lin, const std::size_t& col)
+               const std::size_t& lin, const std::size_t& col,
+               Statistic* mean, Statistic* variance, Statistic* cv,
+               Statistic* thirdMoment, Statistic* fourthMoment, Statistic* contrast)
   : m_id(id),
     m_size(1),
-    m_mean(pixel),
     m_xStart(col),
-    m_xBound(col + 1),
     m_yStart(lin),
-    m_yBound(lin + 1)
+    m_xBound(col + 1),
+    m_yBound(lin + 1),
+    m_nBands(pixel.size()),
+    m_mean(mean),
+    m_variance(variance),
+    m_cv(cv),
+    m_thirdMoment(thirdMoment),
+    m_fourthMoment(fourthMoment),
+    m_contrast(contrast),
+    m_nPairs(0),
+    m_runsNormalized(true),
+    m_cachedClosest(0),
+    m_cachedClosestEpoch(0),
+    m_mergeEpoch(0),
+    m_poolSlot(0)
 {
-  m_variance.resize(pixel.size(), 0.0);
-  m_cv.resize(pixel.size(), 0.0);
+  assert(m_mean);
+  assert(m_variance);
+  assert(m_cv);
+
+  std::copy(pixel.begin(), pixel.end(), m_mean);
+  std::fill(m_variance, m_variance + m_nBands, 0.0);
+  std::fill(m_cv, m_cv + m_nBands, 0.0);
+
+  // A pixel has no texture
+  if(m_thirdMoment)
+    std::fill(m_thirdMoment, m_thirdMoment + m_nBands, 0.0);
+
+  if(m_fourthMoment)
+    std::fill(m_fourthMoment, m_fourthMoment + m_nBands, 0.0);
+
+  if(m_contrast)
+    std::fill(m_contrast, m_contrast + m_nBands, 0.0);
 }
 
 Region::~Region()
@@ -125,42 +155,83 @@ const std::size_t& Region::getYBound() const
   return m_yBound;
 }
 
-std::vector<double>& Region::getMean()
+Region::Statistic* Region::getMean()
 {
   return m_mean;
 }
 
-std::vector<double>& Region::getVariance()
+Region::Statistic* Region::getVariance()
 {
   return m_variance;
 }
 
-std::vector<double>& Region::getCV()
+Region::Statistic* Region::getCV()
 {
   return m_cv;
 }
 
 void Region::setMean(const std::vector<double>& mean)
 {
-  m_mean = mean;
+  assert(mean.size() == m_nBands);
+  std::copy(mean.begin(), mean.end(), m_mean);
 }
 
 void Region::setVariance(const std::vector<double>& variance)
 {
-  m_variance = variance;
+  assert(variance.size() == m_nBands);
+  std::copy(variance.begin(), variance.end(), m_variance);
 }
 
 void Region::setCV(const std::vector<double>& cv)
 {
-  m_cv = cv;
+  assert(cv.size() == m_nBands);
+  std::copy(cv.begin(), cv.end(), m_cv);
 }
 
-void Region::addNeighbour(Region* region)
+Region::Statistic* Region::getThirdMoment()
 {
-  if(isNeighbour(region))
+  return m_thirdMoment;
+}
+
+Region::Statistic* Region::getFourthMoment()
+{
+  return m_fourthMoment;
+}
+
+Region::Statistic* Region::getContrast()
+{
+  return m_contrast;
+}
+
+const std::size_t& Region::getNPairs() const
+{
+  return m_nPairs;
+}
+
+void Region::setNPairs(const std::size_t& nPairs)
+{
+  m_nPairs = nPairs;
+}
+
+void Region::addPixelPairs(const std::size_t& nPairs, const double* squares)
+{
+  assert(m_contrast);
+
+  if(nPairs == 0)
     return;
 
-  m_neighbours.push_back(region);
+  const double n1 = static_cast<double>(m_nPairs);
+  const double n = static_cast<double>(m_nPairs + nPairs);
+
+  for(std::size_t i = 0; i < m_nBands; ++i)
+    m_contrast[i] = static_cast<Statistic>((m_contrast[i] * n1 + squares[i]) / n);
+
+  m_nPairs += nPairs;
+}
+
+void Region::addNeighbour(Region* region)
+{
+  m_neighbours.insert(region);
 }
 
 void Region::removeNeighbour(Region* region)
@@ -168,20 +239,155 @@ void Region::removeNeighbour(Region* region)
   m_neighbours.remove(region);
 }
 
-std::list<Region*>& Region::getNeighbours()
+Neighbourhood& Region::getNeighbours()
 {
   return m_neighbours;
 }
 
 bool Region::isNeighbour(Region* region)
 {
-  std::list<Region*>::iterator it = std::find(m_neighbours.begin(),
-                                              m_neighbours.end(),
-                                              region);
-  return it != m_neighbours.end();
+  return m_neighbours.contains(region);
+}
+
+void Region::getPixelRuns(std::vector<PixelRun>& runs)
+{
+  if(m_runs.empty())
+  {
+    // Uses the bounding box lines
+    runs.resize(m_yBound - m_yStart);
+
+    for(std::size_t i = 0; i < runs.size(); ++i)
+    {
+      runs[i].m_lin = m_yStart + i;
+      runs[i].m_colStart = m_xStart;
+      runs[i].m_colBound = m_xBound;
+    }
+
+    return;
+  }
+
+  normalizePixelRuns();
+
+  runs = m_runs;
+}
+
+void Region::setPixelRuns(const std::vector<PixelRun>& runs)
+{
+  m_runs = runs;
+  m_runsNormalized = true;
+}
+
+void Region::appendPixelRun(const PixelRun& run)
+{
+  assert(m_runs.empty() || m_runs.back() < run);
+  m_runs.push_back(run);
+}
+
+void Region::addPixel(const std::size_t& lin, const std::size_t& col)
+{
+  createPixelRuns();
+
+  PixelRun run;
+  run.m_lin = lin;
+  run.m_colStart = col;
+  run.m_colBound = col + 1;
+
+  m_runs.push_back(run);
+  m_runsNormalized = false;
+}
+
+void Region::absorbPixelRuns(Region* region)
+{
+  assert(region);
+
+  createPixelRuns();
+
+  if(region->m_runs.empty())
+  {
+    // Uses the bounding box lines of the given region
+    PixelRun run;
+    run.m_colStart = region->m_xStart;
+    run.m_colBound = region->m_xBound;
+
+    for(run.m_lin = region->m_yStart; run.m_lin < region->m_yBound; ++run.m_lin)
+      m_runs.push_back(run);
+  }
+  else
+  {
+    m_runs.insert(m_runs.end(), region->m_runs.begin(), region->m_runs.end());
+  }
+
+  m_runsNormalized = false;
+}
+
+bool Region::getCachedClosestRegion(const std::size_t& epoch, Region*& closest) const
+{
+  if(m_cachedClosestEpoch == 0 || m_cachedClosestEpoch != epoch)
+    return false;
+
+  closest = m_cachedClosest;
+
+  return true;
+}
+
+void Region::setCachedClosestRegion(const std::size_t& epoch, Region* closest)
+{
+  assert(epoch > 0);
+
+  m_cachedClosest = closest;
+  m_cachedClosestEpoch = epoch;
+}
+
+void Region::invalidateCachedClosestRegion()
+{
+  m_cachedClosest = 0;
+  m_cachedClosestEpoch = 0;
+}
+
+std::size_t Region::increaseMergeEpoch()
+{
+  return ++m_mergeEpoch;
+}
+
+const std::size_t& Region::getMergeEpoch() const
+{
+  return m_mergeEpoch;
+}
+
+void Region::createPixelRuns()
+{
+  if(!m_runs.empty())
+    return;
+
+  getPixelRuns(m_runs);
+  m_runsNormalized = true;
+}
+
+void Region::normalizePixelRuns()
+{
+  if(m_runsNormalized)
+    return;
+
+  std::sort(m_runs.begin(), m_runs.end());
+
+  // Joins the overlapping and adjacent runs
+  std::size_t last = 0;
+  for(std::size_t i = 1; i < m_runs.size(); ++i)
+  {
+    if(m_runs[i].m_lin == m_runs[last].m_lin && m_runs[i].m_colStart <= m_runs[last].m_colBound)
+    {
+      m_runs[last].m_colBound = (std::max)(m_runs[last].m_colBound, m_runs[i].m_colBound);
+      continue;
+    }
+
+    m_runs[++last] = m_runs[i];
+  }
+
+  m_runs.resize(last + 1);
+  m_runsNormalized = true;
 }
 
 std::size_t Region::getNBands() const
 {
-  return m_mean.size();
+  return m_nBands;
 }
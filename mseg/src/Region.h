@@ -27,11 +27,28 @@
 
 // MultiSeg
 #include "Config.h"
+#include "Neighbourhood.h"
 
 // STL
-#include <list>
 #include <vector>
 
+/*!
+  \struct PixelRun
+
+  \brief A horizontal run of pixels: the columns [m_colStart, m_colBound) of the line m_lin.
+*/
+struct PixelRun
+{
+  std::size_t m_lin;      //!< The run line.
+  std::size_t m_colStart; //!< The first column of the run.
+  std::size_t m_colBound; //!< The column after the last column of the run.
+
+  bool operator<(const PixelRun& rhs) const
+  {
+    return m_lin < rhs.m_lin || (m_lin == rhs.m_lin && m_colStart < rhs.m_colStart);
+  }
+};
+
 /*!
   \class Region
 
@@ -39,18 +56,39 @@
 */
 class MSEGEXPORT Region
 {
+  friend class RegionPool;
+
   public:
 
+    /*! \brief The storage type of the region statistics (mean, variance and coefficient of variation). \sa MSEGFLOAT32 */
+#ifdef MSEGFLOAT32
+    typedef float Statistic;
+#else
+    typedef double Statistic;
+#endif
+
     /*!
       \brief It initializes a region. Here, a region is a pixel.
 
-      \param id    Identifier that will be associated with this region.
-      \param pixel The pixel values.
-      \param lin   The pixel line.
-      \param col   The pixel column.
+      \param id       Identifier that will be associated with this region.
+      \param pixel    The pixel values.
+      \param lin      The pixel line.
+      \param col      The pixel column.
+      \param mean     The storage of the region mean values. i.e. pixel.size() values.
+      \param variance The storage of the region variance values. i.e. pixel.size() values.
+      \param cv       The storage of the region coefficient of variation values. i.e. pixel.size() values.
+      \param thirdMoment  The storage of the region third central moment values. i.e. pixel.size() values, or NULL if it is not tracked.
+      \param fourthMoment The storage of the region fourth central moment values. i.e. pixel.size() values, or NULL if it is not tracked.
+      \param contrast     The storage of the region contrast values. i.e. pixel.size() values, or NULL if it is not tracked.
+
+      \note The region does not take the ownership of the given storages.
+
+      \sa RegionPool
     */
     Region(const std::size_t& id, const std::vector<double>& pixel,
-           const std::size_t& lin, const std::size_t& col);
+           const std::size_t& lin, const std::size_t& col,
+           Statistic* mean, Statistic* variance, Statistic* cv,
+           Statistic* thirdMoment = 0, Statistic* fourthMoment = 0, Statistic* contrast = 0);
 
     /*! \brief Virtual destructor. */
     virtual ~Region();
@@ -144,23 +182,23 @@ class MSEGEXPORT Region
     /*!
       \brief This method returns the region mean.
 
-      \return The region mean.
+      \return The region mean. i.e. getNBands() values.
     */
-    std::vector<double>& getMean();
+    Statistic* getMean();
 
     /*!
       \brief This method returns the region variance.
 
-      \return The region variance.
+      \return The region variance. i.e. getNBands() values.
     */
-    std::vector<double>& getVariance();
+    Statistic* getVariance();
 
     /*!
       \brief This method returns the region coefficient of variation.
 
-      \return The region coefficient of variation.
+      \return The region coefficient of variation. i.e. getNBands() values.
     */
-    std::vector<double>& getCV();
+    Statistic* getCV();
 
     /*!
       \brief This method sets the region mean.
@@ -183,6 +221,58 @@ class MSEGEXPORT Region
     */
     void setCV(const std::vector<double>& cv);
 
+    /** @name Texture Statistics
+      * Mergeable statistics of the texture of the region, tracked only if the region pool allocated their storage.
+      * The higher order central moments are the sums of the powers of the deviations to the mean, divided by the
+      * region size, as the variance. The contrast is the mean of the squared differences of the pixel pairs of the
+      * region, horizontal and vertical neighbours. i.e. the compact form of the co-occurrence sums at distance 1. */
+    //@{
+
+    /*!
+      \brief This method returns the region third central moment.
+
+      \return The region third central moment. i.e. getNBands() values, or NULL if it is not tracked.
+    */
+    Statistic* getThirdMoment();
+
+    /*!
+      \brief This method returns the region fourth central moment.
+
+      \return The region fourth central moment. i.e. getNBands() values, or NULL if it is not tracked.
+    */
+    Statistic* getFourthMoment();
+
+    /*!
+      \brief This method returns the region contrast.
+
+      \return The region contrast. i.e. getNBands() values, or NULL if it is not tracked.
+    */
+    Statistic* getContrast();
+
+    /*!
+      \brief This method returns the number of pixel pairs of the region. i.e. the number of values of its contrast.
+
+      \return The number of pixel pairs of the region.
+    */
+    const std::size_t& getNPairs() const;
+
+    /*!
+      \brief This method sets the number of pixel pairs of the region.
+
+      \param nPairs The number of pixel pairs of the region.
+    */
+    void setNPairs(const std::size_t& nPairs);
+
+    /*!
+      \brief This method adds pixel pairs to the region contrast. e.g. the pairs across the border of a merged region.
+
+      \param nPairs  The number of pixel pairs.
+      \param squares The sum of the squared differences of the pixel pairs. i.e. getNBands() values.
+    */
+    void addPixelPairs(const std::size_t& nPairs, const double* squares);
+
+    //@}
+
     /*!
       \brief This method adds a neighbour region to this region.
 
@@ -198,11 +288,11 @@ class MSEGEXPORT Region
     void removeNeighbour(Region* region);
 
     /*!
-      \brief This method returns the list of neighbours from this region.
+      \brief This method returns the neighbours from this region.
 
-      \return The list of neighbours from this region.
+      \return The neighbours from this region.
     */
-    std::list<Region*>& getNeighbours();
+    Neighbourhood& getNeighbours();
 
     /*!
       \brief This method returns if the given region is neighbour of this region.
@@ -211,6 +301,96 @@ class MSEGEXPORT Region
     */
     bool isNeighbour(Region* region);
 
+    /** @name Pixel Runs
+      * Optional run-length description of the region pixels. The runs always cover all region pixels,
+      * but they may also cover pixels that were moved to others regions. So, the labels must still be checked.
+      * A region without runs is described by its bounding box. */
+    //@{
+
+    /*!
+      \brief This method returns the pixel runs that cover the region, sorted by line and column.
+
+      \param runs The pixel runs. If the region has no runs, each line of its bounding box is returned as a run.
+    */
+    void getPixelRuns(std::vector<PixelRun>& runs);
+
+    /*!
+      \brief This method replaces the region pixel runs.
+
+      \param runs The new pixel runs, sorted by line and column. An empty vector means that the bounding box will be used.
+    */
+    void setPixelRuns(const std::vector<PixelRun>& runs);
+
+    /*!
+      \brief This method appends a pixel run to the region.
+
+      \param run The pixel run. It must come after all region runs, considering the lines and columns order.
+    */
+    void appendPixelRun(const PixelRun& run);
+
+    /*!
+      \brief This method adds a pixel to the region runs.
+
+      \param lin The pixel line.
+      \param col The pixel column.
+
+      \note It must be called before the bounding box is updated with the given pixel.
+    */
+    void addPixel(const std::size_t& lin, const std::size_t& col);
+
+    /*!
+      \brief This method adds the pixel runs of the given region to this region.
+
+      \param region The region whose pixels will be absorbed. e.g. a merged region.
+
+      \note It must be called before the bounding box is updated with the given region.
+    */
+    void absorbPixelRuns(Region* region);
+
+    //@}
+
+    /** @name Closest Region Cache
+      * The closest neighbour found for the region by the region growing process. The cached value is tagged
+      * with an epoch, so increasing the epoch discards the cached values of all regions at once. */
+    //@{
+
+    /*!
+      \brief This method returns the cached closest neighbour, if it was cached on the given epoch.
+
+      \param epoch   The current epoch.
+      \param closest The cached closest neighbour. NULL means that the region has no closest neighbour.
+
+      \return It returns true if there is a cached value for the given epoch and false otherwise.
+    */
+    bool getCachedClosestRegion(const std::size_t& epoch, Region*& closest) const;
+
+    /*!
+      \brief This method caches the closest neighbour.
+
+      \param epoch   The current epoch. It must be greater than 0.
+      \param closest The closest neighbour. NULL means that the region has no closest neighbour.
+    */
+    void setCachedClosestRegion(const std::size_t& epoch, Region* closest);
+
+    /*! \brief This method discards the cached closest neighbour. e.g. the region or its neighbourhood changed. */
+    void invalidateCachedClosestRegion();
+
+    /*!
+      \brief This method increases the merge epoch of the region. The merge candidates queued with a previous epoch are stale.
+
+      \return The new merge epoch.
+    */
+    std::size_t increaseMergeEpoch();
+
+    /*!
+      \brief This method returns the merge epoch of the region.
+
+      \return The merge epoch of the region.
+    */
+    const std::size_t& getMergeEpoch() const;
+
+    //@}
+
     /*!
       \brief This method returns the region number of bands.
 
@@ -218,6 +398,20 @@ class MSEGEXPORT Region
     */
     std::size_t getNBands() const;
 
+  private:
+
+    /*! \brief This method converts the bounding box lines to runs, if the region has no runs. */
+    void createPixelRuns();
+
+    /*! \brief This method sorts the pixel runs and joins the adjacent ones. */
+    void normalizePixelRuns();
+
+    /*! \brief No copy allowed. */
+    Region(const Region& rhs);
+
+    /*! \brief No copy allowed. */
+    Region& operator=(const Region& rhs);
+
   protected:
 
     std::size_t m_id;                         //!< Region id.
@@ -226,10 +420,21 @@ class MSEGEXPORT Region
     std::size_t m_yStart;                     //!< Region upper Y coordinate box over the label image.
     std::size_t m_xBound;                     //!< Region right bound X coordinate box over the label image.
     std::size_t m_yBound;                     //!< Region lower bound Y coordinate box over the label image.
-    std::vector<double> m_mean;               //!< Region mean values (for each band).
-    std::vector<double> m_variance;           //!< Region variance values (for each band).
-    std::vector<double> m_cv;                 //!< Region coefficient of variation values (for each band).
-    std::list<Region*> m_neighbours;          //!< Neighbours regions.
+    std::size_t m_nBands;                     //!< Region number of bands.
+    Statistic* m_mean;                        //!< Region mean values (for each band).
+    Statistic* m_variance;                    //!< Region variance values (for each band).
+    Statistic* m_cv;                          //!< Region coefficient of variation values (for each band).
+    Statistic* m_thirdMoment;                 //!< Region third central moment values (for each band), or NULL.
+    Statistic* m_fourthMoment;                //!< Region fourth central moment values (for each band), or NULL.
+    Statistic* m_contrast;                    //!< Region contrast values (for each band), or NULL.
+    std::size_t m_nPairs;                     //!< Region number of pixel pairs.
+    Neighbourhood m_neighbours;               //!< Neighbours regions.
+    std::vector<PixelRun> m_runs;             //!< Pixel runs that cover the region. Empty means the bounding box.
+    bool m_runsNormalized;                    //!< A flag that indicates if the pixel runs are sorted and joined.
+    Region* m_cachedClosest;                  //!< The cached closest neighbour.
+    std::size_t m_cachedClosestEpoch;         //!< The epoch of the cached closest neighbour. 0 means no cached value.
+    std::size_t m_mergeEpoch;                 //!< The epoch of the queued merge candidate of the region. See MultiSeg::mergeRegionsByPriority().
+    std::size_t m_poolSlot;                   //!< The slot of the region on the RegionPool that created it.
 };
 
 #endif  // __MULTISEG_INTERNAL_REGION_H
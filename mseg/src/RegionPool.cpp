@@ -0,0 +1,158 @@
+/*  Copyright (C) 2014 National Institute For Space Research (INPE) - Brazil.
+
+    MultiSeg is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    MultiSeg is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with MultiSeg. See COPYING.
+ */
+
+/*!
+  \file RegionPool.cpp
+
+  \brief This class implements an arena that allocates regions and their band statistics in slabs.
+
+  \author Douglas Uba <douglas@dpi.inpe.br>
+*/
+
+// MultiSeg
+#include "Region.h"
+#include "RegionPool.h"
+
+// STL
+#include <cassert>
+#include <new>
+
+RegionPool::RegionPool(const std::size_t& nBands, const std::size_t& slabSize,
+                       const bool& higherMoments, const bool& contrast)
+  : m_nBands(nBands),
+    m_slabSize(slabSize),
+    m_higherMoments(higherMoments),
+    m_contrast(contrast),
+    m_nSlots(0),
+    m_size(0)
+{
+  assert(m_slabSize > 0);
+}
+
+RegionPool::~RegionPool()
+{
+  // Destroys the remaining regions
+  for(std::size_t slot = 0; slot < m_nSlots; ++slot)
+  {
+    if(m_live[slot])
+      (m_regionSlabs[slot / m_slabSize] + (slot % m_slabSize))->~Region();
+  }
+
+  // Releases all slabs
+  for(std::size_t i = 0; i < m_regionSlabs.size(); ++i)
+  {
+    ::operator delete(m_regionSlabs[i]);
+    delete [] m_meanSlabs[i];
+    delete [] m_varianceSlabs[i];
+    delete [] m_cvSlabs[i];
+  }
+
+  for(std::size_t i = 0; i < m_thirdMomentSlabs.size(); ++i)
+  {
+    delete [] m_thirdMomentSlabs[i];
+    delete [] m_fourthMomentSlabs[i];
+  }
+
+  for(std::size_t i = 0; i < m_contrastSlabs.size(); ++i)
+    delete [] m_contrastSlabs[i];
+}
+
+Region* RegionPool::create(const std::size_t& id, const std::vector<double>& pixel,
+                           const std::size_t& lin, const std::size_t& col)
+{
+  assert(pixel.size() == m_nBands);
+
+  std::size_t slot;
+
+  if(!m_freeSlots.empty())
+  {
+    // Reuses a slot
+    slot = m_freeSlots.back();
+    m_freeSlots.pop_back();
+  }
+  else
+  {
+    if(m_nSlots == m_regionSlabs.size() * m_slabSize)
+      allocateSlab();
+
+    slot = m_nSlots++;
+    m_live.push_back(false);
+  }
+
+  std::size_t slab = slot / m_slabSize;
+  std::size_t offset = slot % m_slabSize;
+
+  Region* memory = m_regionSlabs[slab] + offset;
+
+  // Statistics storage: m_nBands contiguous values on each statistics slab
+  Region* region = new(memory) Region(id, pixel, lin, col,
+                                      m_meanSlabs[slab] + offset * m_nBands,
+                                      m_varianceSlabs[slab] + offset * m_nBands,
+                                      m_cvSlabs[slab] + offset * m_nBands,
+                                      m_higherMoments ? m_thirdMomentSlabs[slab] + offset * m_nBands : 0,
+                                      m_higherMoments ? m_fourthMomentSlabs[slab] + offset * m_nBands : 0,
+                                      m_contrast ? m_contrastSlabs[slab] + offset * m_nBands : 0);
+  region->m_poolSlot = slot;
+
+  m_live[slot] = true;
+  ++m_size;
+
+  return region;
+}
+
+void RegionPool::destroy(Region* region)
+{
+  assert(region);
+
+  // O(1): the region knows its slot
+  std::size_t slot = region->m_poolSlot;
+
+  assert(slot < m_nSlots && m_live[slot]);
+  assert(region == m_regionSlabs[slot / m_slabSize] + (slot % m_slabSize));
+
+  region->~Region();
+
+  m_live[slot] = false;
+  m_freeSlots.push_back(slot);
+  --m_size;
+}
+
+std::size_t RegionPool::getNBands() const
+{
+  return m_nBands;
+}
+
+std::size_t RegionPool::size() const
+{
+  return m_size;
+}
+
+void RegionPool::allocateSlab()
+{
+  m_regionSlabs.push_back(static_cast<Region*>(::operator new(m_slabSize * sizeof(Region))));
+  m_meanSlabs.push_back(new Region::Statistic[m_slabSize * m_nBands]);
+  m_varianceSlabs.push_back(new Region::Statistic[m_slabSize * m_nBands]);
+  m_cvSlabs.push_back(new Region::Statistic[m_slabSize * m_nBands]);
+
+  if(m_higherMoments)
+  {
+    m_thirdMomentSlabs.push_back(new Region::Statistic[m_slabSize * m_nBands]);
+    m_fourthMomentSlabs.push_back(new Region::Statistic[m_slabSize * m_nBands]);
+  }
+
+  if(m_contrast)
+    m_contrastSlabs.push_back(new Region::Statistic[m_slabSize * m_nBands]);
+}
@@ -0,0 +1,130 @@
+/*  Copyright (C) 2014 National Institute For Space Research (INPE) - Brazil.
+
+    MultiSeg is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    MultiSeg is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with MultiSeg. See COPYING.
+ */
+
+/*!
+  \file RegionPool.h
+
+  \brief This class implements an arena that allocates regions and their band statistics in slabs.
+
+  \author Douglas Uba <douglas@dpi.inpe.br>
+*/
+
+#ifndef __MULTISEG_INTERNAL_REGIONPOOL_H
+#define __MULTISEG_INTERNAL_REGIONPOOL_H
+
+// MultiSeg
+#include "Config.h"
+#include "Region.h"
+
+// STL
+#include <vector>
+
+/*!
+  \class RegionPool
+
+  \brief This class implements an arena that allocates regions and their band statistics in slabs.
+
+  Regions are created in place on slabs of slabSize regions. The band statistics are kept as a
+  structure of arrays: the means, the variances and the coefficients of variation of the regions
+  are stored on three parallel slabs, each one with nBands contiguous values per region slot.
+  Thus, the band loops of the mergers stream a single statistic of a region with contiguous loads.
+  The texture statistics (see Region) have their own slabs, allocated only if they are tracked.
+  A destroyed region slot is kept in a free list and reused by the next creation, so no heap
+  allocation is done per region. Each region records its slot, so it is destroyed in O(1). All slabs are released at once when the pool is destroyed.
+*/
+class MSEGEXPORT RegionPool
+{
+  public:
+
+    /*!
+      \brief Constructor.
+
+      \param nBands        The number of bands of the regions.
+      \param slabSize      The number of regions of each slab.
+      \param higherMoments A flag that indicates if the third and fourth central moments of the regions are tracked.
+      \param contrast      A flag that indicates if the contrast of the regions is tracked.
+    */
+    RegionPool(const std::size_t& nBands, const std::size_t& slabSize = 65536,
+               const bool& higherMoments = false, const bool& contrast = false);
+
+    /*! \brief Destructor. It destroys the remaining regions and releases all slabs. */
+    ~RegionPool();
+
+    /*!
+      \brief This method creates a new region. Here, a region is a pixel.
+
+      \param id    Identifier that will be associated with the new region.
+      \param pixel The pixel values.
+      \param lin   The pixel line.
+      \param col   The pixel column.
+
+      \return The new region.
+    */
+    Region* create(const std::size_t& id, const std::vector<double>& pixel,
+                   const std::size_t& lin, const std::size_t& col);
+
+    /*!
+      \brief This method destroys the given region. Its slot will be reused.
+
+      \param region The region that will be destroyed.
+    */
+    void destroy(Region* region);
+
+    /*!
+      \brief This method returns the number of bands of the regions.
+
+      \return The number of bands of the regions.
+    */
+    std::size_t getNBands() const;
+
+    /*!
+      \brief This method returns the number of live regions.
+
+      \return The number of live regions.
+    */
+    std::size_t size() const;
+
+  private:
+
+    /*! \brief This method allocates a new slab. */
+    void allocateSlab();
+
+    /*! \brief No copy allowed. */
+    RegionPool(const RegionPool& rhs);
+
+    /*! \brief No copy allowed. */
+    RegionPool& operator=(const RegionPool& rhs);
+
+  private:
+
+    std::size_t m_nBands;                   //!< The number of bands of the regions.
+    std::size_t m_slabSize;                 //!< The number of regions of each slab.
+    std::vector<Region*> m_regionSlabs;     //!< The slabs of regions.
+    std::vector<Region::Statistic*> m_meanSlabs;     //!< The slabs of band means. nBands values for each region slot.
+    std::vector<Region::Statistic*> m_varianceSlabs; //!< The slabs of band variances. nBands values for each region slot.
+    std::vector<Region::Statistic*> m_cvSlabs;       //!< The slabs of band coefficients of variation. nBands values for each region slot.
+    std::vector<Region::Statistic*> m_thirdMomentSlabs;  //!< The slabs of band third central moments, if they are tracked.
+    std::vector<Region::Statistic*> m_fourthMomentSlabs; //!< The slabs of band fourth central moments, if they are tracked.
+    std::vector<Region::Statistic*> m_contrastSlabs;     //!< The slabs of band contrasts, if they are tracked.
+    bool m_higherMoments;                   //!< A flag that indicates if the third and fourth central moments are tracked.
+    bool m_contrast;                        //!< A flag that indicates if the contrast is tracked.
+    std::vector<bool> m_live;               //!< A flag for each slot that indicates if it holds a live region.
+    std::vector<std::size_t> m_freeSlots;   //!< The slots of the destroyed regions.
+    std::size_t m_nSlots;                   //!< The number of slots already handed out.
+    std::size_t m_size;                     //!< The number of live regions.
+};
+
+#endif // __MULTISEG_INTERNAL_REGIONPOOL_H
@@ -0,0 +1,182 @@
+/*  Copyright (C) 2014 National Institute For Space Research (INPE) - Brazil.
+
+    MultiSeg is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    MultiSeg is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with MultiSeg. See COPYING.
+ */
+
+/*!
+  \file RegionTable.cpp
+
+  \brief This class implements a dense table of regions indexed by region identifier.
+
+  \author Douglas Uba <douglas@dpi.inpe.br>
+*/
+
+// MultiSeg
+#include "Region.h"
+#include "RegionTable.h"
+
+RegionTable::const_iterator::const_iterator()
+  : m_table(0),
+    m_slot(std::string::npos)
+{
+}
+
+RegionTable::const_iterator::const_iterator(const RegionTable* table, const std::size_t& slot)
+  : m_table(table),
+    m_slot(slot)
+{
+}
+
+RegionTable::RegionTable()
+  : m_base(0),
+    m_head(std::string::npos),
+    m_tail(std::string::npos),
+    m_size(0)
+{
+}
+
+RegionTable::~RegionTable()
+{
+}
+
+void RegionTable::reserve(const std::size_t& n)
+{
+  m_slots.reserve(n);
+  m_next.reserve(n);
+  m_prev.reserve(n);
+}
+
+void RegionTable::insert(Region* region)
+{
+  assert(region);
+
+  const std::size_t& id = region->getId();
+
+  // The first region defines the base identifier
+  if(m_slots.empty())
+    m_base = id;
+
+  assert(id >= m_base);
+
+  std::size_t slot = id - m_base;
+
+  if(slot >= m_slots.size())
+  {
+    m_slots.resize(slot + 1, 0);
+    m_next.resize(slot + 1, std::string::npos);
+    m_prev.resize(slot + 1, std::string::npos);
+  }
+
+  if(m_slots[slot] == 0)
+  {
+    link(slot);
+    ++m_size;
+  }
+
+  m_slots[slot] = region;
+}
+
+void RegionTable::erase(const std::size_t& id)
+{
+  if(get(id) == 0)
+    return;
+
+  std::size_t slot = id - m_base;
+
+  // Unlink the slot from the live regions list
+  std::size_t prev = m_prev[slot];
+  std::size_t next = m_next[slot];
+
+  prev == std::string::npos ? m_head = next : m_next[prev] = next;
+  next == std::string::npos ? m_tail = prev : m_prev[next] = prev;
+
+  m_slots[slot] = 0;
+  m_next[slot] = std::string::npos;
+  m_prev[slot] = std::string::npos;
+
+  --m_size;
+
+  // No more live regions. Releases the slots
+  if(m_size == 0)
+    clear();
+}
+
+Region* RegionTable::back() const
+{
+  if(m_tail == std::string::npos)
+    return 0;
+
+  return m_slots[m_tail];
+}
+
+std::size_t RegionTable::size() const
+{
+  return m_size;
+}
+
+bool RegionTable::empty() const
+{
+  return m_size == 0;
+}
+
+void RegionTable::clear()
+{
+  std::vector<Region*>().swap(m_slots);
+  std::vector<std::size_t>().swap(m_next);
+  std::vector<std::size_t>().swap(m_prev);
+
+  m_head = std::string::npos;
+  m_tail = std::string::npos;
+  m_size = 0;
+}
+
+RegionTable::const_iterator RegionTable::begin() const
+{
+  return const_iterator(this, m_head);
+}
+
+RegionTable::const_iterator RegionTable::end() const
+{
+  return const_iterator(this, std::string::npos);
+}
+
+void RegionTable::link(const std::size_t& slot)
+{
+  // Common case: identifiers are generated in increasing order
+  if(m_tail == std::string::npos || slot > m_tail)
+  {
+    m_prev[slot] = m_tail;
+    m_next[slot] = std::string::npos;
+
+    m_tail == std::string::npos ? m_head = slot : m_next[m_tail] = slot;
+    m_tail = slot;
+
+    return;
+  }
+
+  // Searches the previous live slot to keep the identifier order
+  std::size_t prev = slot;
+  while(prev > 0 && m_slots[prev - 1] == 0)
+    --prev;
+
+  prev = (prev == 0) ? std::string::npos : prev - 1;
+
+  std::size_t next = (prev == std::string::npos) ? m_head : m_next[prev];
+
+  m_prev[slot] = prev;
+  m_next[slot] = next;
+
+  prev == std::string::npos ? m_head = slot : m_next[prev] = slot;
+  m_prev[next] = slot;
+}
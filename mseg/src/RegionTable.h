@@ -0,0 +1,218 @@
+/*  Copyright (C) 2014 National Institute For Space Research (INPE) - Brazil.
+
+    MultiSeg is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    MultiSeg is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with MultiSeg. See COPYING.
+ */
+
+/*!
+  \file RegionTable.h
+
+  \brief This class implements a dense table of regions indexed by region identifier.
+
+  \author Douglas Uba <douglas@dpi.inpe.br>
+*/
+
+#ifndef __MULTISEG_INTERNAL_REGIONTABLE_H
+#define __MULTISEG_INTERNAL_REGIONTABLE_H
+
+// MultiSeg
+#include "Config.h"
+
+// STL
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <string>
+#include <vector>
+
+// Forward declaration
+class Region;
+
+/*!
+  \class RegionTable
+
+  \brief This class implements a dense table of regions indexed by region identifier.
+
+  Each region identifier is mapped directly to a slot (identifier - base identifier), so the lookup is O(1).
+  Removed regions leave a tombstone on its slot. The live regions are chained in a doubly linked list
+  ordered by identifier, so the iteration visits only the live regions and removals are O(1).
+
+  \note The table does not own the regions. i.e. it never deletes them.
+
+  \note Removing a region invalidates only the iterators that point to it.
+*/
+class MSEGEXPORT RegionTable
+{
+  public:
+
+    /*!
+      \class const_iterator
+
+      \brief Forward iterator over the live regions, in identifier order.
+    */
+    class const_iterator
+    {
+      public:
+
+        typedef std::forward_iterator_tag iterator_category;
+        typedef Region* value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef Region* const* pointer;
+        typedef Region* reference;
+
+        const_iterator();
+
+        const_iterator(const RegionTable* table, const std::size_t& slot);
+
+        Region* operator*() const;
+
+        const_iterator& operator++();
+
+        bool operator==(const const_iterator& rhs) const;
+
+        bool operator!=(const const_iterator& rhs) const;
+
+      private:
+
+        const RegionTable* m_table; //!< The iterated table.
+        std::size_t m_slot;         //!< The current slot.
+    };
+
+    friend class const_iterator;
+
+    typedef const_iterator iterator;
+
+    /*! \brief Default constructor. */
+    RegionTable();
+
+    /*! \brief Destructor. */
+    ~RegionTable();
+
+    /*!
+      \brief This method reserves memory to the given number of slots.
+
+      \param n The number of slots.
+    */
+    void reserve(const std::size_t& n);
+
+    /*!
+      \brief This method indexes the given region by its identifier.
+
+      \param region The region that will be indexed.
+
+      \note Identifiers greater than the last indexed identifier are appended in O(1).
+    */
+    void insert(Region* region);
+
+    /*!
+      \brief This method removes the region identified by the given id. Nothing is done if it is not indexed.
+
+      \param id The region identifier.
+    */
+    void erase(const std::size_t& id);
+
+    /*!
+      \brief This method returns the region identified by the given id.
+
+      \param id The region identifier.
+
+      \return The region identified by the given id or NULL if it is not indexed.
+    */
+    Region* get(const std::size_t& id) const;
+
+    /*!
+      \brief This method returns the region with the greatest identifier.
+
+      \return The region with the greatest identifier or NULL if the table is empty.
+    */
+    Region* back() const;
+
+    /*!
+      \brief This method returns the number of live regions.
+
+      \return The number of live regions.
+    */
+    std::size_t size() const;
+
+    /*!
+      \brief This method returns if the table has no live regions.
+
+      \return It returns true if the table has no live regions and false otherwise.
+    */
+    bool empty() const;
+
+    /*! \brief This method removes all regions and releases the slots. */
+    void clear();
+
+    const_iterator begin() const;
+
+    const_iterator end() const;
+
+  private:
+
+    /*! \brief This method links the given slot to the live regions list. */
+    void link(const std::size_t& slot);
+
+  private:
+
+    std::size_t m_base;                //!< The identifier associated with the first slot.
+    std::vector<Region*> m_slots;      //!< The slots. NULL means an empty slot (tombstone).
+    std::vector<std::size_t> m_next;   //!< The next live slot of each live slot.
+    std::vector<std::size_t> m_prev;   //!< The previous live slot of each live slot.
+    std::size_t m_head;                //!< The first live slot.
+    std::size_t m_tail;                //!< The last live slot.
+    std::size_t m_size;                //!< The number of live regions.
+};
+
+inline Region* RegionTable::get(const std::size_t& id) const
+{
+  if(id < m_base)
+    return 0;
+
+  std::size_t slot = id - m_base;
+
+  if(slot >= m_slots.size())
+    return 0;
+
+  return m_slots[slot];
+}
+
+inline Region* RegionTable::const_iterator::operator*() const
+{
+  assert(m_table);
+  assert(m_slot < m_table->m_slots.size());
+
+  return m_table->m_slots[m_slot];
+}
+
+inline RegionTable::const_iterator& RegionTable::const_iterator::operator++()
+{
+  assert(m_table);
+  assert(m_slot < m_table->m_next.size());
+
+  m_slot = m_table->m_next[m_slot];
+
+  return *this;
+}
+
+inline bool RegionTable::const_iterator::operator==(const const_iterator& rhs) const
+{
+  return m_slot == rhs.m_slot;
+}
+
+inline bool RegionTable::const_iterator::operator!=(const const_iterator& rhs) const
+{
+  return m_slot != rhs.m_slot;
+}
+
+#endif // __MULTISEG_INTERNAL_REGIONTABLE_H
@@ -0,0 +1,120 @@
+/*  Copyright (C) 2014 National Institute For Space Research (INPE) - Brazil.
+
+    MultiSeg is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    MultiSeg is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with MultiSeg. See COPYING.
+ */
+
+/*!
+  \file TextureMerger.cpp
+
+  \brief This class implements the base of the mergers to texture images.
+
+  \author Douglas Uba <douglas@dpi.inpe.br>
+*/
+
+// MultiSeg
+#include "Region.h"
+#include "TextureMerger.h"
+#include "Utils.h"
+
+// STL
+#include <cassert>
+
+const std::size_t TextureMerger::sm_minTextureSize = 16;
+
+TextureMerger::TextureMerger()
+  : EuclideanMerger()
+{
+}
+
+TextureMerger::~TextureMerger()
+{
+}
+
+bool TextureMerger::predicate(Region* r1, Region* r2) const
+{
+  return evaluatePredicate(this, r1, r2);
+}
+
+std::size_t TextureMerger::predicates(Region* region, const std::vector<Region*>& regions,
+                                      std::vector<unsigned char>& passes, std::vector<double>& distances) const
+{
+  return evaluatePredicates(this, region, regions, passes, distances);
+}
+
+void TextureMerger::merge(Region* r1, Region* r2) const
+{
+  assert(r1);
+  assert(r2);
+  assert(r1->getNBands() ==  r2->getNBands());
+
+  const double n1 = static_cast<double>(r1->getSize());
+  const double n2 = static_cast<double>(r2->getSize());
+
+  // Updating higher order moments: from the statistics of both regions, before the mean and variance are updated
+  Region::Statistic* thirdMoment1 = r1->getThirdMoment();
+  Region::Statistic* fourthMoment1 = r1->getFourthMoment();
+
+  if(thirdMoment1 && fourthMoment1)
+  {
+    const Region::Statistic* mean1 = r1->getMean();
+    const Region::Statistic* mean2 = r2->getMean();
+
+    const Region::Statistic* variance1 = r1->getVariance();
+    const Region::Statistic* variance2 = r2->getVariance();
+
+    const Region::Statistic* thirdMoment2 = r2->getThirdMoment();
+    const Region::Statistic* fourthMoment2 = r2->getFourthMoment();
+
+    const double n = n1 + n2;
+
+    for(std::size_t i = 0; i < r1->getNBands(); ++i)
+    {
+      // The moments are stored divided by the region size
+      double m2 = variance1[i] * n1;
+      double m3 = thirdMoment1[i] * n1;
+      double m4 = fourthMoment1[i] * n1;
+
+      Utils::CombineCentralMoments(n1, n2, static_cast<double>(mean2[i]) - mean1[i], m2, m3, m4,
+                                   variance2[i] * n2, thirdMoment2[i] * n2, fourthMoment2[i] * n2);
+
+      thirdMoment1[i] = static_cast<Region::Statistic>(m3 / n);
+      fourthMoment1[i] = static_cast<Region::Statistic>(m4 / n);
+    }
+  }
+
+  // Updating contrast: the pixel pairs inside each region. The pairs across their border are added by the segmenter
+  Region::Statistic* contrast1 = r1->getContrast();
+
+  if(contrast1)
+  {
+    const Region::Statistic* contrast2 = r2->getContrast();
+
+    const std::size_t nPairs = r1->getNPairs() + r2->getNPairs();
+
+    if(nPairs != 0)
+    {
+      const double p1 = static_cast<double>(r1->getNPairs());
+      const double p2 = static_cast<double>(r2->getNPairs());
+      const double p = static_cast<double>(nPairs);
+
+      for(std::size_t i = 0; i < r1->getNBands(); ++i)
+        contrast1[i] = static_cast<Region::Statistic>((contrast1[i] * p1 + contrast2[i] * p2) / p);
+    }
+
+    r1->setNPairs(nPairs);
+  }
+
+  // Updating bounds, size, mean and variance
+  EuclideanMerger::merge(r1, r2);
+}
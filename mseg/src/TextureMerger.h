@@ -0,0 +1,115 @@
+/*  Copyright (C) 2014 National Institute For Space Research (INPE) - Brazil.
+
+    MultiSeg is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    MultiSeg is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with MultiSeg. See COPYING.
+ */
+
+
+/*!
+  \file TextureMerger.h
+
+  \brief This class implements the base of the mergers to texture images.
+
+  \author Douglas Uba <douglas@dpi.inpe.br>
+*/
+
+#ifndef __MULTISEG_INTERNAL_TEXTUREMERGER_H
+#define __MULTISEG_INTERNAL_TEXTUREMERGER_H
+
+// MutiSeg
+#include "Config.h"
+#include "EuclideanMerger.h"
+
+// STL
+#include <cassert>
+
+/*!
+  \class TextureMerger
+
+  \brief This class implements the base of the mergers to texture images.
+
+  The small regions, whose texture can not be estimated, are compared through the euclidean predicate.
+  The other ones are compared by the concrete merger, band by band, through the compareTexture() method.
+
+  The merge updates the texture statistics that the regions track (see Region): the third and fourth
+  central moments are combined through the pairwise update of Pebay, and the contrast of the pixel pairs
+  inside each region is weighted by the number of pairs. The pairs across the border of the merged regions
+  are added after the merge, from the boundary table of the segmenter. So, a merge is O(bands).
+
+  \sa AbstractMerger, EuclideanMerger, RadarTextureMerger, OpticalTextureMerger
+*/
+class MSEGEXPORT TextureMerger : public EuclideanMerger
+{
+  public:
+
+    /*! \brief Default constructor. */
+    TextureMerger();
+
+    /*! \brief Virtual destructor. */
+    virtual ~TextureMerger();
+
+    bool predicate(Region* r1, Region* r2) const;
+
+    std::size_t predicates(Region* region, const std::vector<Region*>& regions,
+                           std::vector<unsigned char>& passes, std::vector<double>& distances) const;
+
+    /*!
+      \brief This method merges the region r2 into the region r1.
+
+      \param r1 The region that will grow.
+      \param r2 The region that will be merged.
+
+      \note The texture statistics of r1 are updated before its size, mean and variance (see EuclideanMerger::merge()).
+    */
+    void merge(Region* r1, Region* r2) const;
+
+  protected:
+
+    bool predicate(Region* r1, Region* r2, const std::size_t& band) const;
+
+    /*!
+      \brief This method evaluates if the textures of two regions are homogeneous considering a specific band.
+
+      \param r1   The first region.
+      \param r2   The second region.
+      \param band The band that will be used.
+
+      \retrun It returns true if the textures are not significantly different and false otherwise.
+
+      \note Both regions have at least sm_minTextureSize pixels.
+    */
+    virtual bool compareTexture(Region* r1, Region* r2, const std::size_t& band) const = 0;
+
+  protected:
+
+    static const std::size_t sm_minTextureSize; //!< The minimum size of the regions whose texture is compared.
+
+  friend class AbstractMerger;
+};
+
+inline bool TextureMerger::predicate(Region* r1, Region* r2, const std::size_t& band) const
+{
+  assert(r1);
+  assert(r2);
+  assert(r1->getNBands() ==  r2->getNBands());
+
+  // pixel vs. pixel, pixel vs. region or small regions
+  if(r1->getSize() < sm_minTextureSize || r2->getSize() < sm_minTextureSize)
+    return EuclideanMerger::predicate(r1, r2, band);
+
+  assert(band < r1->getNBands());
+
+  return compareTexture(r1, r2, band);
+}
+
+#endif // __MULTISEG_INTERNAL_TEXTUREMERGER_H
@@ -48,7 +48,10 @@ TePDITypes::TePDIRasterPtrType Utils::Amplitude2Intensity(TePDITypes::TePDIRaste
   TeRasterParams params = image->params();
   params.decoderIdentifier_ = "SMARTMEM";
   params.mode_ = 'w';
-  params.setDataType(TeDOUBLE);
+  params.setDataType(MSEG_STORAGE_DATATYPE);
+
+  // It is not the image file anymore. e.g. the pyramid cache must not take it by the file
+  params.fileName_.clear();
 
   TeRaster* intensityImage = new TeRaster(params);
   intensityImage->init();
@@ -172,13 +175,10 @@ void Utils::GenerateOutputFilesNames(const TePDIParameters& params, const std::s
     baseName += QString::number(cv, 'g', precision).toStdString();
     baseName += separator;
     
-    if(type == Optical)
-    {
-      double confidenceLevel; // Confidence Level
-      params.GetParameter("confidence_level", confidenceLevel);
-      baseName += QString::number(confidenceLevel, 'g', precision).toStdString();
-      baseName += separator;
-    }
+    double confidenceLevel; // Confidence Level
+    params.GetParameter("confidence_level", confidenceLevel);
+    baseName += QString::number(confidenceLevel, 'g', precision).toStdString();
+    baseName += separator;
   }
 
   // Minimum Area
@@ -206,7 +206,7 @@ void Utils::SaveResult(const MultiSeg& mseg, const std::string& outputDir, std::
   TePDIUtils::TeRaster2Geotiff(li2Save, outputDir + "/" + outputFilesNames[LabelledImage] + ".tif");
 
   // Gets the regions
-  const std::map<std::size_t, Region*>& regions = mseg.getRegions();
+  const RegionTable& regions = mseg.getRegions();
 
   // Vectorizing...
   TePDITypes::TePDIPolSetMapPtrType polygons(new TePDITypes::TePDIPolSetMapType);
@@ -252,24 +252,34 @@ void Utils::SaveResult(const MultiSeg& mseg, const std::string& outputDir, std::
   double idValue;
   bool valueWasRead;
 
-  std::map<std::size_t, Region*>::const_iterator itRegions;
+  std::vector<PixelRun> runs;
+
+  RegionTable::const_iterator itRegions;
   for(itRegions = regions.begin(); itRegions != regions.end(); ++itRegions)
   {
-    Region* currentRegion = itRegions->second;
+    Region* currentRegion = *itRegions;
     assert(currentRegion);
 
+    // Gets the region number of bands
+    const std::size_t nBands = currentRegion->getNBands();
+
     // Gets the region mean
-    const std::vector<double>& mean = currentRegion->getMean();
+    const Region::Statistic* mean = currentRegion->getMean();
 
     // Gets the region variance
-    const std::vector<double>& variance = currentRegion->getVariance();
+    const Region::Statistic* variance = currentRegion->getVariance();
 
     // Gets the region cv
-    const std::vector<double>& cv = currentRegion->getCV();
+    const Region::Statistic* cv = currentRegion->getCV();
 
-    for(std::size_t lin = currentRegion->getYStart(); lin < currentRegion->getYBound(); ++lin)
+    // Gets the region pixels
+    currentRegion->getPixelRuns(runs);
+
+    for(std::size_t r = 0; r < runs.size(); ++r)
     { 
-      for(std::size_t col = currentRegion->getXStart(); col < currentRegion->getXBound(); ++col)
+      const std::size_t lin = runs[r].m_lin;
+
+      for(std::size_t col = runs[r].m_colStart; col < runs[r].m_colBound; ++col)
       {
         valueWasRead = labelledImage->getElement(col, lin, idValue);
         assert(valueWasRead);
@@ -280,15 +290,15 @@ void Utils::SaveResult(const MultiSeg& mseg, const std::string& outputDir, std::
         int currentBand = 0;
 
         // Write mean
-        for(std::size_t b = currentBand; b < mean.size(); ++b, ++currentBand)
+        for(std::size_t b = currentBand; b < nBands; ++b, ++currentBand)
           cartoonImage->setElement(col, lin, mean[b], currentBand);
 
         // Write variance
-        for(std::size_t b = 0; b < variance.size(); ++b, ++currentBand)
+        for(std::size_t b = 0; b < nBands; ++b, ++currentBand)
           cartoonImage->setElement(col, lin, variance[b], currentBand);
 
         // Write cv
-        for(std::size_t b = 0; b < cv.size(); ++b, ++currentBand)
+        for(std::size_t b = 0; b < nBands; ++b, ++currentBand)
           cartoonImage->setElement(col, lin, cv[b], currentBand);
       }
     }
@@ -333,3 +343,50 @@ std::size_t Utils::ComputeMaxLevels(const std::size_t& nlines, const std::size_t
 
   return maxlevels;
 }
+
+bool Utils::IsSmallIntegerImage(const TePDITypes::TePDIRasterPtrType& image, const std::vector<std::size_t>& bands)
+{
+  if(bands.empty())
+    return false;
+
+  for(std::size_t i = 0; i < bands.size(); ++i)
+  {
+    switch(image->params().dataType_[bands[i]])
+    {
+      case TeUNSIGNEDCHAR:
+      case TeCHAR:
+      case TeUNSIGNEDSHORT:
+      case TeSHORT:
+      break;
+
+      default:
+        return false;
+    }
+  }
+
+  return true;
+}
+
+void Utils::CombineCentralMoments(const double& nA, const double& nB, const double& delta,
+                                  double& m2A, double& m3A, double& m4A,
+                                  const double& m2B, const double& m3B, const double& m4B)
+{
+  const double n = nA + nB;
+  if(n == 0.0)
+    return;
+
+  const double delta2 = delta * delta;
+  const double nAnB = nA * nB;
+
+  // Note: each order reads the lower orders of both sets before they are combined
+  const double m4 = m4A + m4B + delta2 * delta2 * nAnB * (nA * nA - nAnB + nB * nB) / (n * n * n) +
+                    6.0 * delta2 * (nA * nA * m2B + nB * nB * m2A) / (n * n) + 4.0 * delta * (nA * m3B - nB * m3A) / n;
+
+  const double m3 = m3A + m3B + delta2 * delta * nAnB * (nA - nB) / (n * n) + 3.0 * delta * (nA * m2B - nB * m2A) / n;
+
+  const double m2 = m2A + m2B + delta2 * nAnB / n;
+
+  m2A = m2;
+  m3A = m3;
+  m4A = m4;
+}
@@ -46,6 +46,8 @@ namespace Utils
     \param image The image with amplitude values.
 
     \return The image with intensity values.
+
+    \note The segmentation does not use it: the pyramid converts the values while its base level is read. See Pyramid::setInputFormat().
   */
   MSEGEXPORT TePDITypes::TePDIRasterPtrType Amplitude2Intensity(TePDITypes::TePDIRasterPtrType& image);
 
@@ -112,6 +114,35 @@ namespace Utils
     \return The maximum levels of hierarchical pyramid based on the given sizes.
   */
   MSEGEXPORT std::size_t ComputeMaxLevels(const std::size_t& nlines, const std::size_t& ncols, const std::size_t& minimumSize = 2);
+
+  /*!
+    \brief This method verifies if the given bands of an image hold 8 or 16 bits integer values.
+
+    \param image The image.
+    \param bands The bands that will be verified.
+
+    \return It returns true if all given bands are 8 or 16 bits integers (signed or not) and false otherwise.
+  */
+  MSEGEXPORT bool IsSmallIntegerImage(const TePDITypes::TePDIRasterPtrType& image, const std::vector<std::size_t>& bands);
+
+  /*!
+    \brief This method combines the central moments of two sets of values into the ones of their union (Pebay pairwise update).
+
+    \param nA    The number of values of the first set.
+    \param nB    The number of values of the second set.
+    \param delta The mean of the second set minus the mean of the first set.
+    \param m2A   The sum of the squared deviations of the first set. It receives the sum of the union.
+    \param m3A   The sum of the cubed deviations of the first set. It receives the sum of the union.
+    \param m4A   The sum of the fourth powers of the deviations of the first set. It receives the sum of the union.
+    \param m2B   The sum of the squared deviations of the second set.
+    \param m3B   The sum of the cubed deviations of the second set.
+    \param m4B   The sum of the fourth powers of the deviations of the second set.
+
+    \note The deviations are taken from the mean of each set. The sums are not divided by the number of values.
+  */
+  MSEGEXPORT void CombineCentralMoments(const double& nA, const double& nB, const double& delta,
+                                        double& m2A, double& m3A, double& m4A,
+                                        const double& m2B, const double& m3B, const double& m4B);
 }
 
 #endif  // __MULTISEG_INTERNAL_UTILS_H